@@ -10,7 +10,7 @@ void axpy(int N, T alpha, const T* x, T* y) {
 }
 
 int main() {
-  const size_t vector_length = 2000;
+  const size_t vector_length = 2001;
   std::vector<float> x_host(vector_length, 1.0);
   std::vector<float> y_host(vector_length, 0.0);
   const float alpha = 1.0;
@@ -31,24 +31,30 @@ int main() {
   sycl::event copy_x = sycl_queue.copy(x_host.data(), x, x_host.size());
   sycl::event copy_y = sycl_queue.copy(y_host.data(), y, y_host.size());
 
-  // Each work-item will compute 4 entries
+  // Each work-item will compute up to 4 entries. Round the number of
+  // work-items up, so vector_length need not be divisible by 4.
   constexpr int thread_vector_length{4};
+  const size_t number_of_work_items =
+      (vector_length + thread_vector_length - 1) / thread_vector_length;
 
   sycl::event axpy_kernel = sycl_queue.parallel_for(
-      {vector_length / thread_vector_length}, {copy_x, copy_y},
+      {number_of_work_items}, {copy_x, copy_y},
       // Here we need the kernel function to take a sycl::item argument since we
       // need the range
       [=](sycl::item<1> work_item) {
         // These are private to each work-item
-        float x_thread[thread_vector_length];
-        float y_thread[thread_vector_length];
+        float x_thread[thread_vector_length]{};
+        float y_thread[thread_vector_length]{};
 
         int i = work_item.get_linear_id();
         int r = work_item.get_range(0);
 
+        // The last entries of the last work-items are past the end
         for (int n{}; n < thread_vector_length; ++n) {
-          x_thread[n] = x[i + r * n];
-          y_thread[n] = y[i + r * n];
+          if (i + r * n < vector_length) {
+            x_thread[n] = x[i + r * n];
+            y_thread[n] = y[i + r * n];
+          }
         }
 
         // Since we are calling the function inside a kernel,
@@ -56,7 +62,7 @@ int main() {
         axpy(thread_vector_length, alpha, x_thread, y_thread);
 
         for (int n{}; n < thread_vector_length; ++n) {
-          y[i + r * n] = y_thread[n];
+          if (i + r * n < vector_length) y[i + r * n] = y_thread[n];
         }
       });
 
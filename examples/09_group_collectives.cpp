@@ -1,50 +1,38 @@
 #include <CL/sycl.hpp>
-#include <random>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 
-int main() {
-  size_t number_of_nodes = 8;
-  size_t number_of_elements = 1000;
-  size_t nodes_per_element = number_of_nodes * number_of_nodes;
-  size_t boundary_per_element = 4 * (number_of_nodes - 1);
-  size_t total_nodes = number_of_elements * nodes_per_element;
-  size_t total_boundary = number_of_elements * boundary_per_element;
-
-  std::vector<int> u_host(total_nodes);
-  std::vector<int> ub_host(total_boundary);
-  std::vector<int> ub_valid(total_boundary);
-
-  int b = 0;
-  for (int e{}; e < number_of_elements; ++e) {
-    for (int j{}; j < number_of_nodes; ++j) {
-      for (int i{}; i < number_of_nodes; ++i) {
-        int index = i + number_of_nodes * j + nodes_per_element * e;
-        u_host[index] = index;
-        bool on_boundary = (i == 0) || (i == (number_of_nodes - 1)) ||
-                           (j == 0) || (j == (number_of_nodes - 1));
-        if (on_boundary) {
-          ub_valid[b] = index;
-          ++b;
-        }
-      }
-    }
-  }
-
-  sycl::device sycl_device{sycl::default_selector()};
-  sycl::context sycl_context{sycl_device};
-  sycl::queue sycl_queue{sycl_context, sycl_device};
+namespace {
 
-  int* u = sycl::malloc_device<int>(total_nodes, sycl_device, sycl_context);
-  int* ub = sycl::malloc_device<int>(total_boundary, sycl_device, sycl_context);
-
-  sycl::event copy_u = sycl_queue.copy(u_host.data(), u, total_nodes);
+// Polynomial orders with a compile-time specialization. An element of order
+// p has p + 1 nodes along each side.
+constexpr size_t min_order{4};
+constexpr size_t max_order{12};
 
+// Copies the boundary nodes of each element of u to ub. number_of_nodes is
+// either a size_t, known only at runtime, or a std::integral_constant, in
+// which case every % and / by it and every boundary test in the kernel is
+// computed at compile time.
+template <typename Nodes>
+sycl::event extractBoundary(sycl::queue& sycl_queue, Nodes number_of_nodes,
+                            size_t number_of_elements, const int* u, int* ub,
+                            const std::vector<sycl::event>& dependencies) {
+  const size_t nodes_per_element = number_of_nodes * number_of_nodes;
   sycl::range<2> local_range(1, nodes_per_element);
   sycl::range<2> global_range(number_of_elements, nodes_per_element);
   sycl::nd_range<2> kernel_range(global_range, local_range);
 
-  sycl::event boundary_kernel = sycl_queue.parallel_for(
-      kernel_range, {copy_u}, [=](sycl::nd_item<2> work_item) {
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<2> work_item) {
+        // Recomputed from number_of_nodes, so they are constants too
+        const size_t nodes_per_element = number_of_nodes * number_of_nodes;
+        const size_t boundary_per_element = 4 * (number_of_nodes - 1);
+
         int e = work_item.get_global_id(0);
         int ij = work_item.get_local_id(1);
 
@@ -62,16 +50,114 @@ int main() {
           ub[b + boundary_per_element * e] = u[ij + nodes_per_element * e];
         }
       });
+}
+
+// Calls f with the number of nodes of polynomial_order as a
+// std::integral_constant, i.e., turns the runtime order into a compile-time
+// one by trying each supported order in turn.
+template <size_t order = min_order, typename F>
+sycl::event dispatchOrder(size_t polynomial_order, F f) {
+  if constexpr (order > max_order) {
+    throw std::invalid_argument("No kernel for polynomial order " +
+                                std::to_string(polynomial_order));
+  } else {
+    if (order == polynomial_order) {
+      return f(std::integral_constant<size_t, order + 1>());
+    }
+    return dispatchOrder<order + 1>(polynomial_order, f);
+  }
+}
+
+// Mean time of number_of_trials calls to launch(), in ms
+template <typename F>
+double meanTime(size_t number_of_trials, F launch) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (size_t trial = 0; trial < number_of_trials; ++trial) launch().wait();
+  auto finish_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(finish_time - start_time)
+             .count() /
+         number_of_trials;
+}
 
-  // Copy the result from the device to the host; synchronize.
-  sycl_queue.copy(ub, ub_host.data(), total_boundary, {boundary_kernel}).wait();
+}  // namespace
 
-  // Verify the results
-  for (int b{}; b < total_boundary; ++b) {
-    if (ub_valid[b] != ub_host[b]) {
-      std::cout << "Verification failed!\n";
+int main() {
+  size_t number_of_elements = 10000;
+  size_t number_of_trials = 100;
+  size_t max_nodes = max_order + 1;
+  size_t max_total_nodes = number_of_elements * max_nodes * max_nodes;
+
+  sycl::device sycl_device{sycl::default_selector()};
+  sycl::context sycl_context{sycl_device};
+  sycl::queue sycl_queue{sycl_context, sycl_device};
+
+  int* u = sycl::malloc_device<int>(max_total_nodes, sycl_device, sycl_context);
+  int* ub =
+      sycl::malloc_device<int>(max_total_nodes, sycl_device, sycl_context);
+
+  std::cout << std::setw(6) << "order" << std::setw(14) << "runtime (ms)"
+            << std::setw(14) << "fixed (ms)" << std::setw(10) << "speedup"
+            << "\n";
+
+  for (size_t order = min_order; order <= max_order; ++order) {
+    size_t number_of_nodes = order + 1;
+    size_t nodes_per_element = number_of_nodes * number_of_nodes;
+    size_t boundary_per_element = 4 * (number_of_nodes - 1);
+    size_t total_nodes = number_of_elements * nodes_per_element;
+    size_t total_boundary = number_of_elements * boundary_per_element;
+
+    std::vector<int> u_host(total_nodes);
+    std::vector<int> ub_host(total_boundary);
+    std::vector<int> ub_valid(total_boundary);
+
+    int b = 0;
+    for (int e{}; e < number_of_elements; ++e) {
+      for (int j{}; j < number_of_nodes; ++j) {
+        for (int i{}; i < number_of_nodes; ++i) {
+          int index = i + number_of_nodes * j + nodes_per_element * e;
+          u_host[index] = index;
+          bool on_boundary = (i == 0) || (i == (number_of_nodes - 1)) ||
+                             (j == 0) || (j == (number_of_nodes - 1));
+          if (on_boundary) {
+            ub_valid[b] = index;
+            ++b;
+          }
+        }
+      }
+    }
+
+    sycl::event copy_u = sycl_queue.copy(u_host.data(), u, total_nodes);
+
+    auto runtime_kernel = [&]() {
+      return extractBoundary(sycl_queue, number_of_nodes, number_of_elements,
+                             u, ub, {copy_u});
+    };
+    auto fixed_kernel = [&]() {
+      return dispatchOrder(order, [&](auto nodes) {
+        return extractBoundary(sycl_queue, nodes, number_of_elements, u, ub,
+                               {copy_u});
+      });
+    };
+
+    // Verify both kernels; these runs also warm them up
+    auto verify = [&](sycl::event boundary_kernel) {
+      sycl_queue.copy(ub, ub_host.data(), total_boundary, {boundary_kernel})
+          .wait();
+      bool is_valid = (ub_valid == ub_host);
+      sycl_queue.memset(ub, 0, total_boundary * sizeof(int)).wait();
+      return is_valid;
+    };
+    if (!verify(runtime_kernel()) || !verify(fixed_kernel())) {
+      std::cout << "Verification failed for order " << order << "!\n";
       return EXIT_FAILURE;
     }
+
+    double runtime_time = meanTime(number_of_trials, runtime_kernel);
+    double fixed_time = meanTime(number_of_trials, fixed_kernel);
+    std::cout << std::setw(6) << order << std::fixed << std::setprecision(4)
+              << std::setw(14) << runtime_time << std::setw(14) << fixed_time
+              << std::setprecision(2) << std::setw(10)
+              << runtime_time / fixed_time << "\n";
   }
 
   std::cout << "Success!\n";
@@ -1,17 +1,52 @@
 #include <CL/sycl.hpp>
+#include <iomanip>
 #include <iostream>
 
+#include "selector.hpp"
+
 struct GPUWithFP64AtomicsSelector : sycl::device_selector {
   int operator()(const sycl::device& sycl_device) const {
-    // If no suitable device can be found, cause an exception
-    return -1;
+    // Devices without the required aspects score -1. If no suitable device
+    // can be found, constructing a sycl::device causes an exception.
+    return benchmark_selector(sycl_device);
   }
+
+  // Requires a GPU with fp64 and atomic64, and ranks suitable devices by
+  // their (cached) microbenchmark scores
+  selector::benchmark_selector_t benchmark_selector{
+      {/*gpu=*/true, /*fp64=*/true, /*atomic64=*/true}};
 };
 
 int main() {
-  sycl::device gpu_with_fp64_atomics{GPUWithFP64AtomicsSelector()};
-  auto device_name = gpu_with_fp64_atomics.get_info<sycl::info::device::name>();
-  std::cout << "Selected " << device_name << "\n";
+  // Score every device which supports USM device allocations
+  selector::benchmark_selector_t benchmark_selector;
+  std::cout << "Device scores (cached in " << selector::defaultCacheFile()
+            << ")\n";
+  for (const auto& sycl_device : sycl::device::get_devices()) {
+    std::cout << selector::deviceKey(sycl_device) << ": ";
+    if (!selector::meetsRequirements(sycl_device, {})) {
+      std::cout << "no USM device allocations\n";
+      continue;
+    }
+    auto score = benchmark_selector.score(sycl_device);
+    std::cout << std::fixed << std::setprecision(1) << score.bandwidth
+              << " GB/s, " << score.gflops << " GFLOP/s\n";
+  }
+  std::cout << "\n";
+
+  try {
+    sycl::device fastest{benchmark_selector};
+    std::cout << "Fastest device: "
+              << fastest.get_info<sycl::info::device::name>() << "\n";
+
+    sycl::device gpu_with_fp64_atomics{GPUWithFP64AtomicsSelector()};
+    auto device_name =
+        gpu_with_fp64_atomics.get_info<sycl::info::device::name>();
+    std::cout << "Selected " << device_name << "\n";
+  } catch (const sycl::exception& e) {
+    std::cerr << "No suitable device: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
 
   std::cout << "Success\n";
   return EXIT_SUCCESS;
@@ -1,48 +1,355 @@
 #include <CL/sycl.hpp>
+#include <atomic>
 #include <exception>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "axpy.hpp"
+#include "device_blas.hpp"
+#include "host_blas.hpp"
+#include "matrix_io.hpp"
+#include "memory_pool.hpp"
+#include "partition.hpp"
+#include "precision.hpp"
+#include "staging.hpp"
+#include "timing.hpp"
 
 namespace {
 
-// Given a group of vectors of the same length, compute
-// for (b=0; b < batch_size; ++b) {
-//   Y += alpha * X + Y
-// }
-// where X is a vector located at offset stride_x * b in x
-// and Y is a vector located at offset stride_Y * b in y
-//
-// N is the size of contiguous memory used to store the vectors
-template <typename T>
-sycl::event axpy_batch(sycl::queue& queue, int64_t N, T alpha, const T* x,
-                       int64_t stride_x, T* y, int64_t stride_y,
-                       int64_t batch_size,
-                       const std::vector<sycl::event>& dependencies = {}) {
-  if (N < batch_size * stride_x) {
-    throw std::logic_error("N is smaller than batch_size * stride_x");
-  }
-  if (N < batch_size * stride_y) {
-    throw std::logic_error("N is smaller than batch_size * stride_y");
-  }
-
-  sycl::event kernel_event = queue.parallel_for(
-      {1, 1},  // Correct this. Remember, the last dimension is the "fastest".
-      dependencies, [=](sycl::id<2> index) {
-        // Find the batch index, and the index within the current vector
-        // int batch_i = ???;
-        // int i = ???;
-
-        // Create pointers to the start of each vector for this axpy.
-        // const T* batch_x = x + ???;
-        // T* batch_y = y + ???;
-
-        // Calculate axpy for the current vectors.
-        // batch_y[i] += alpha * batch_x[i];
-      });
-
-  return kernel_event;
+using device_blas::axpy_batch;
+
+// Verify axpy_batch with vectors stored as T and arithmetic done in Tacc,
+// then time it. y_valid is the result computed in full precision. Returns
+// false if verification fails.
+template <typename T, typename Tacc>
+bool runBenchmark(sycl::queue& sycl_queue, memory_pool::device_pool_t& pool,
+                  int64_t N, int64_t batch_size, size_t number_of_trials,
+                  float alpha,
+                  matrix_io::array_view_t<float> x_host,
+                  matrix_io::array_view_t<float> y_host,
+                  const std::vector<float>& y_valid) {
+  std::cout << "Storage: " << precision::traits<T>::name
+            << ", Accumulation: " << precision::traits<Tacc>::name << "\n";
+
+  const int64_t total_size = N * batch_size;
+
+  // x and y as stored on the device, and rounded back to float. Stored as
+  // float, the host arrays are used as they are rather than copied.
+  std::vector<T> x_storage;
+  std::vector<T> y_storage;
+  std::vector<float> x_converted;
+  const T* x_source = nullptr;
+  const T* y_source = nullptr;
+  matrix_io::array_view_t<float> x_rounded = x_host;
+  std::vector<float> y_expected;
+  if constexpr (std::is_same<T, float>::value) {
+    x_source = x_host.data();
+    y_source = y_host.data();
+    y_expected.assign(y_host.begin(), y_host.end());
+  } else {
+    x_storage = precision::convert<T>(x_host);
+    y_storage = precision::convert<T>(y_host);
+    x_converted = precision::convert<float>(x_storage);
+    x_source = x_storage.data();
+    y_source = y_storage.data();
+    x_rounded = x_converted;
+    y_expected = precision::convert<float>(y_storage);
+  }
+
+  // Reference result for the rounded inputs, and a bound on the size of the
+  // terms used to compute each entry.
+  std::vector<float> y_scale(total_size);
+  for (int64_t i = 0; i < total_size; ++i) {
+    y_scale[i] = std::abs(alpha * x_rounded[i]) + std::abs(y_expected[i]);
+  }
+  host_blas::axpy_batch(N, alpha, x_rounded.data(), N, y_expected.data(), N,
+                        batch_size);
+
+  T* x = pool.allocate<T>(total_size);
+  T* y = pool.allocate<T>(total_size);
+
+  sycl::event copy_x = sycl_queue.copy(x_source, x, total_size);
+  sycl::event copy_y = sycl_queue.copy(y_source, y, total_size);
+
+  sycl::event axpy_batch_kernel =
+      axpy_batch(sycl_queue, total_size, Tacc(alpha), x, N, y, N, batch_size,
+                 {copy_x, copy_y});
+
+  std::vector<T> y_result(total_size);
+  sycl_queue.copy(y, y_result.data(), total_size, {axpy_batch_kernel}).wait();
+
+  // Each entry is rounded once when computed in Tacc and once when stored
+  const double tolerance = 2.0 * (precision::traits<T>::epsilon +
+                                  precision::traits<Tacc>::epsilon);
+  bool is_valid = precision::verify(y_expected, y_result, y_scale, tolerance);
+
+  if (is_valid) {
+    auto times = timing::timeTrials(sycl_queue, number_of_trials, [&]() {
+      return axpy_batch(sycl_queue, total_size, Tacc(alpha), x, N, y, N,
+                        batch_size);
+    });
+
+    // x is read, y is read and written
+    const double bytes = 3.0 * sizeof(T) * double(total_size);
+
+    auto kernel_stats = timing::computeStats(times, {});
+    timing::printStats(kernel_stats);
+    std::cout << "Max relative error: " << std::scientific
+              << precision::maxRelativeError(y_valid, y_result) << "\n";
+    timing::printBandwidth(bytes, kernel_stats.kernel().mean);
+  }
+
+  pool.deallocate(x);
+  pool.deallocate(y);
+  return is_valid;
+}
+
+// Times uploading x and y and running axpy_batch, end to end. Without
+// staging, x and y are copied whole from the host vectors before the kernel
+// starts. With staging, they are copied chunk_size vectors at a time through
+// pinned buffers, and the kernel for each chunk starts once its copies are
+// done, so copies overlap with the kernels of earlier chunks. Returns false
+// if verification fails.
+template <bool is_staged>
+bool runTransferBenchmark(sycl::queue& sycl_queue,
+                          memory_pool::device_pool_t& pool, int64_t N,
+                          int64_t batch_size, int64_t chunk_size,
+                          size_t number_of_trials, float alpha,
+                          matrix_io::array_view_t<float> x_host,
+                          matrix_io::array_view_t<float> y_host,
+                          const std::vector<float>& y_valid,
+                          const std::vector<float>& y_scale) {
+  const int64_t total_size = N * batch_size;
+  float* x = pool.allocate<float>(total_size);
+  float* y = pool.allocate<float>(total_size);
+
+  // One buffer each for x and y of the chunk being copied, and of the chunk
+  // being filled on the host
+  staging::ring_t ring{sycl_queue, sizeof(float) * N * chunk_size, 4};
+
+  auto launch = [&]() {
+    if (!is_staged) {
+      sycl::event copy_x = sycl_queue.copy(x_host.data(), x, total_size);
+      sycl::event copy_y = sycl_queue.copy(y_host.data(), y, total_size);
+      return std::vector<sycl::event>{axpy_batch(sycl_queue, total_size,
+                                                 alpha, x, N, y, N,
+                                                 batch_size, {copy_x, copy_y})};
+    }
+
+    std::vector<sycl::event> events;
+    for (int64_t b = 0; b < batch_size; b += chunk_size) {
+      const int64_t chunk_batch_size = std::min(chunk_size, batch_size - b);
+      const int64_t offset = N * b;
+      const int64_t count = N * chunk_batch_size;
+      sycl::event copy_x =
+          ring.stage(x_host.data() + offset, x + offset, count);
+      sycl::event copy_y =
+          ring.stage(y_host.data() + offset, y + offset, count);
+      events.push_back(axpy_batch(sycl_queue, count, alpha, x + offset, N,
+                                  y + offset, N, chunk_batch_size,
+                                  {copy_x, copy_y}));
+    }
+    return events;
+  };
+
+  std::vector<float> y_result(total_size);
+  sycl_queue.copy(y, y_result.data(), total_size, launch()).wait();
+
+  // Each entry is rounded at most twice on the device and twice on the host
+  const double tolerance = 4.0 * precision::traits<float>::epsilon;
+  bool is_valid = precision::verify(y_valid, y_result, y_scale, tolerance);
+
+  if (is_valid) {
+    auto times = timing::timeTrials(sycl_queue, number_of_trials, launch);
+    auto transfer_stats = timing::computeStats(times, {});
+
+    std::cout << (is_staged ? "Staged" : "Unstaged")
+              << " Copy + axpy_batch Times\n";
+    timing::printStats(transfer_stats);
+  }
+
+  pool.deallocate(x);
+  pool.deallocate(y);
+  return is_valid;
+}
+
+// Device copies of x and y on each partition, with its queue, the pool they
+// are allocated from and its weight for proportional splits (its compute
+// units)
+struct partitions_t {
+  std::vector<sycl::queue> queues;
+  std::vector<std::unique_ptr<memory_pool::device_pool_t>> pools;
+  std::vector<double> weights;
+  std::vector<float*> x;
+  std::vector<float*> y;
+};
+
+// A range of vectors of the batch, and the partition it was computed on
+struct slice_t {
+  size_t partition;
+  int64_t first;
+  int64_t count;
+};
+
+// Splits the batch over the first number_of_partitions partitions in
+// proportion to their weights and waits for all of them to finish.
+std::vector<slice_t> runProportional(partitions_t& partitions,
+                                     size_t number_of_partitions, int64_t N,
+                                     int64_t batch_size, float alpha) {
+  std::vector<double> weights(
+      partitions.weights.begin(),
+      partitions.weights.begin() + number_of_partitions);
+  auto offsets = partition::proportionalSplit(batch_size, weights);
+
+  std::vector<slice_t> slices;
+  std::vector<sycl::event> events;
+  for (size_t p = 0; p < number_of_partitions; ++p) {
+    const int64_t first = offsets[p];
+    const int64_t count = offsets[p + 1] - offsets[p];
+    if (0 == count) continue;
+    events.push_back(axpy_batch(partitions.queues[p], N * count, alpha,
+                                partitions.x[p] + N * first, N,
+                                partitions.y[p] + N * first, N, count));
+    slices.push_back({p, first, count});
+  }
+  sycl::event::wait(events);
+  return slices;
+}
+
+// Hands out grain vectors at a time to whichever partition finishes its
+// previous slice first, so slower partitions get less of the batch. Each
+// partition is driven by its own host thread.
+std::vector<slice_t> runStealing(partitions_t& partitions,
+                                 size_t number_of_partitions, int64_t N,
+                                 int64_t batch_size, int64_t grain,
+                                 float alpha) {
+  std::atomic<int64_t> next{0};
+  std::vector<std::vector<slice_t>> done(number_of_partitions);
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < number_of_partitions; ++p) {
+    threads.emplace_back([&, p]() {
+      for (int64_t first = next.fetch_add(grain); first < batch_size;
+           first = next.fetch_add(grain)) {
+        const int64_t count = std::min(grain, batch_size - first);
+        axpy_batch(partitions.queues[p], N * count, alpha,
+                   partitions.x[p] + N * first, N,
+                   partitions.y[p] + N * first, N, count)
+            .wait();
+        done[p].push_back({p, first, count});
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  std::vector<slice_t> slices;
+  for (const auto& partition_slices : done) {
+    slices.insert(slices.end(), partition_slices.begin(),
+                  partition_slices.end());
+  }
+  return slices;
+}
+
+// Times axpy_batch spread over 1, 2, ... of the partitions, splitting the
+// batch proportionally and by work stealing, and reports the speedup over a
+// single partition. Each partition holds all of x and y, so either schedule
+// can hand it any vector. Returns false if verification fails.
+bool runPartitionedBenchmark(partitions_t& partitions, int64_t N,
+                             int64_t batch_size, size_t number_of_trials,
+                             float alpha, matrix_io::array_view_t<float> x_host,
+                             matrix_io::array_view_t<float> y_host,
+                             const std::vector<float>& y_valid,
+                             const std::vector<float>& y_scale) {
+  const int64_t total_size = N * batch_size;
+  const size_t number_of_partitions = partitions.queues.size();
+  const int64_t grain =
+      std::max<int64_t>(1, batch_size / int64_t(8 * number_of_partitions));
+
+  // Each entry is rounded at most twice on the device and twice on the host
+  const double tolerance = 4.0 * precision::traits<float>::epsilon;
+
+  for (size_t q = 0; q < number_of_partitions; ++q) {
+    partitions.x.push_back(partitions.pools[q]->allocate<float>(total_size));
+    partitions.y.push_back(partitions.pools[q]->allocate<float>(total_size));
+    partitions.queues[q]
+        .copy(x_host.data(), partitions.x.back(), total_size)
+        .wait();
+  }
+
+  // x is read, y is read and written
+  const double bytes = 3.0 * sizeof(float) * double(total_size);
+
+  std::cout << "Partitioned axpy_batch\n";
+  std::cout << std::setw(10) << "partitions" << std::setw(14) << "schedule"
+            << std::setw(12) << "mean (ms)" << std::setw(12) << "GB/s"
+            << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+            << "\n";
+
+  bool is_valid = true;
+  double baseline = 0.0;
+  for (size_t p = 1; p <= number_of_partitions; ++p) {
+    for (bool is_stealing : {false, true}) {
+      auto run = [&]() {
+        return is_stealing ? runStealing(partitions, p, N, batch_size, grain,
+                                         alpha)
+                           : runProportional(partitions, p, N, batch_size,
+                                             alpha);
+      };
+
+      for (size_t q = 0; q < p; ++q) {
+        partitions.queues[q]
+            .copy(y_host.data(), partitions.y[q], total_size)
+            .wait();
+      }
+
+      // Gather each slice of y from the partition that computed it
+      std::vector<float> y_result(total_size);
+      std::vector<sycl::event> copies;
+      for (const auto& slice : run()) {
+        const int64_t offset = N * slice.first;
+        copies.push_back(partitions.queues[slice.partition].copy(
+            partitions.y[slice.partition] + offset, y_result.data() + offset,
+            N * slice.count));
+      }
+      sycl::event::wait(copies);
+      if (!precision::verify(y_valid, y_result, y_scale, tolerance)) {
+        is_valid = false;
+        continue;
+      }
+
+      // run() waits for every partition, so each trial returns no events
+      // and is timed on the host, across all of the queues
+      auto times =
+          timing::timeTrials(partitions.queues.front(), number_of_trials,
+                             [&]() {
+                               run();
+                               return std::vector<sycl::event>{};
+                             });
+      const double mean = timing::computeStats(times, {}).kernel().mean;
+      if (0.0 == baseline) baseline = mean;
+      const double speedup = baseline / mean;
+
+      std::cout << std::setw(10) << p << std::setw(14)
+                << (is_stealing ? "stealing" : "proportional") << std::fixed
+                << std::setprecision(4) << std::setw(12) << mean
+                << std::setprecision(2) << std::setw(12)
+                << (bytes / mean) * 1.0e-6
+                << std::setw(10) << speedup << std::setw(12)
+                << speedup / double(p) << "\n";
+    }
+  }
+  std::cout << "\n";
+
+  for (size_t q = 0; q < number_of_partitions; ++q) {
+    partitions.pools[q]->deallocate(partitions.x[q]);
+    partitions.pools[q]->deallocate(partitions.y[q]);
+  }
+  partitions.x.clear();
+  partitions.y.clear();
+  return is_valid;
 }
 
 }  // namespace
@@ -51,52 +358,144 @@ int main(int argc, char* argv[]) {
   auto arguments = readArguments(argc, argv);
   printArguments(arguments);
 
-  const size_t N = arguments.N;
-  const size_t batch_size = arguments.batch_size;
-  const size_t total_size = N * batch_size;
-
-  std::vector<float> x_host(total_size);
-  std::vector<float> y_host(total_size);
+  partition::mode_t partition_mode{};
+  if (!arguments.partition.empty()) {
+    try {
+      partition_mode = partition::parseMode(arguments.partition);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << "\n";
+      return EXIT_FAILURE;
+    }
+  }
 
+  size_t N = arguments.N;
+  size_t batch_size = arguments.batch_size;
+  const size_t number_of_trials = arguments.trials;
   const float alpha = 1.0;
-  for (size_t b{}; b < batch_size; ++b) {
-    for (size_t i{}; i < N; ++i) {
-      x_host[i + N * b] = float(b);
-      y_host[i + N * b] = float(b);
+
+  // x and y are read from the input file, as N x batch_size column-major
+  // matrices, or generated. Entries read from the file are used in place.
+  std::unique_ptr<matrix_io::mapped_file_t> input_file;
+  std::vector<float> x_generated;
+  std::vector<float> y_generated;
+  matrix_io::array_view_t<float> x_host;
+  matrix_io::array_view_t<float> y_host;
+  if (!arguments.input.empty()) {
+    try {
+      input_file = std::make_unique<matrix_io::mapped_file_t>(arguments.input);
+      auto x_array = input_file->array<float>(0);
+      auto y_array = input_file->array<float>(1);
+      const auto& header = x_array.header;
+      if (matrix_io::layout_t::column_major != header.layout ||
+          header.ld != header.rows || header.rows != y_array.header.rows ||
+          header.columns != y_array.header.columns ||
+          header.ld != y_array.header.ld ||
+          header.layout != y_array.header.layout) {
+        std::cerr << "x and y must be column-major matrices of the same "
+                     "size, without padding\n";
+        return EXIT_FAILURE;
+      }
+      N = header.rows;
+      batch_size = header.columns;
+      x_host = x_array.entries;
+      y_host = y_array.entries;
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << "\n";
+      return EXIT_FAILURE;
     }
+    std::cout << "Input: " << batch_size << " vectors of size " << N
+              << "\n\n";
+  } else {
+    x_generated.resize(N * batch_size);
+    y_generated.resize(N * batch_size);
+    for (size_t b{}; b < batch_size; ++b) {
+      for (size_t i{}; i < N; ++i) {
+        x_generated[i + N * b] = float(b);
+        y_generated[i + N * b] = float(b);
+      }
+    }
+    x_host = x_generated;
+    y_host = y_generated;
+  }
+
+  if (!arguments.output.empty()) {
+    matrix_io::write<float>(
+        arguments.output,
+        {matrix_io::makeArray<float>(N, batch_size, N, x_host.data()),
+         matrix_io::makeArray<float>(N, batch_size, N, y_host.data())});
+  }
+
+  std::vector<float> y_valid(y_host.begin(), y_host.end());
+  host_blas::axpy_batch(N, alpha, x_host.data(), N, y_valid.data(), N,
+                        batch_size);
+
+  // A bound on the size of the terms used to compute each entry of y_valid
+  std::vector<float> y_scale(N * batch_size);
+  for (size_t i = 0; i < y_scale.size(); ++i) {
+    y_scale[i] = std::abs(alpha * x_host[i]) + std::abs(y_host[i]);
   }
 
   sycl::device sycl_device{sycl::default_selector()};
   sycl::context sycl_context{sycl_device};
-  sycl::queue sycl_queue{sycl_context, sycl_device};
-
-  float* x = sycl::malloc_device<float>(total_size, sycl_device, sycl_context);
-  float* y = sycl::malloc_device<float>(total_size, sycl_device, sycl_context);
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
 
-  sycl::event copy_x = sycl_queue.copy(x_host.data(), x, x_host.size());
-  sycl::event copy_y = sycl_queue.copy(y_host.data(), y, y_host.size());
+  bool is_valid = runBenchmark<float, float>(sycl_queue, pool, N, batch_size,
+                                             number_of_trials, alpha, x_host,
+                                             y_host, y_valid);
 
-  sycl::event axpy_batch_kernel = axpy_batch(
-      sycl_queue, total_size, alpha, x, N, y, N, batch_size, {copy_x, copy_y});
+  // Store vectors in half precision, but do arithmetic in single precision
+  if (sycl_device.has(sycl::aspect::fp16)) {
+    is_valid &= runBenchmark<sycl::half, float>(
+        sycl_queue, pool, N, batch_size, number_of_trials, alpha, x_host,
+        y_host, y_valid);
+  } else {
+    std::cout << "Device does not support half precision.\n";
+  }
 
-  sycl_queue.copy(y, y_host.data(), y_host.size(), {axpy_batch_kernel}).wait();
+  if (0 < arguments.chunk_size) {
+    is_valid &= runTransferBenchmark<false>(
+        sycl_queue, pool, N, batch_size, arguments.chunk_size, number_of_trials,
+        alpha, x_host, y_host, y_valid, y_scale);
+    is_valid &= runTransferBenchmark<true>(
+        sycl_queue, pool, N, batch_size, arguments.chunk_size, number_of_trials,
+        alpha, x_host, y_host, y_valid, y_scale);
+  }
 
-  // Verify the results.
-  size_t i{};
-  for (const auto& y_i : y_host) {
-    float expected = 2.0 * float(i / N);
-    if (expected != y_i) {
-      std::cout << "Verification failed!\n";
-      std::cout << "expected: " << expected << ", actual: " << y_i << std::endl;
+  if (!arguments.partition.empty()) {
+    partitions_t partitions;
+    try {
+      auto devices = partition::getDevices(sycl_device, partition_mode,
+                                           arguments.partitions);
+      for (const auto& device : devices) {
+        const auto compute_units =
+            device.get_info<sycl::info::device::max_compute_units>();
+        std::cout << "Partition " << partitions.queues.size() << ": "
+                  << device.get_info<sycl::info::device::name>() << ", "
+                  << compute_units << " compute units\n";
+        partitions.queues.emplace_back(device);
+        partitions.pools.push_back(std::make_unique<memory_pool::device_pool_t>(
+            partitions.queues.back(), !arguments.no_pool));
+        partitions.weights.push_back(compute_units);
+      }
+      std::cout << "\n";
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << "\n";
       return EXIT_FAILURE;
     }
-    ++i;
+    is_valid &= runPartitionedBenchmark(partitions, N, batch_size,
+                                        number_of_trials, alpha, x_host,
+                                        y_host, y_valid, y_scale);
   }
 
-  std::cout << "Success!\n";
+  memory_pool::printStats(pool.stats());
 
-  // Free device memory
-  sycl::free(x, sycl_context);
-  sycl::free(y, sycl_context);
+  if (!is_valid) return EXIT_FAILURE;
+
+  std::cout << "Success!\n";
   return EXIT_SUCCESS;
 }
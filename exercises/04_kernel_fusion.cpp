@@ -1,91 +1,194 @@
 #include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
-#include "stats.hpp"
+#include "bundle.hpp"
+#include "device_blas.hpp"
+#include "expression.hpp"
 #include "fusion.hpp"
+#include "host_blas.hpp"
+#include "memory_pool.hpp"
+#include "stats.hpp"
+#include "timing.hpp"
 
 namespace {
 
-template <typename T>
-sycl::event axpyDot(sycl::queue& sycl_queue, int64_t N, T alpha, const T* x,
-                    T* y, T* normy) {
-  sycl::range<1> kernel_range(N);
-
-  // First compute axpy
-  sycl::event axpy_event = sycl_queue.parallel_for(
-      kernel_range, [=](sycl::id<1> i) { y[i] += alpha * x[i]; });
-
-  // Next compute dot y
-  sycl::event normy_event = sycl_queue.submit([&](sycl::handler& cgh) {
-    cgh.depends_on(axpy_event);
-
-    auto reduce_normy = sycl::reduction(normy, sycl::plus<>());
-    cgh.parallel_for(kernel_range, reduce_normy,
-                     [=](sycl::id<1> it, auto& normy_) {
-                       size_t i = it;
-                       if (i < N) normy_ += y[i] * y[i];
-                     });
-  });
-
-  return normy_event;
-}
+using device_blas::axpyDot;
+using device_blas::axpyDotFused;
+using device_blas::axpyDotSubGroup;
 
-template <typename T>
-sycl::event axpyDotFused(sycl::queue& sycl_queue, int64_t N, T alpha,
-                         const T* x, T* y, T* normy) {
-  sycl::range<1> kernel_range(N);
-
-  // Compute axpy and then dot in the same kernel
-  sycl::event kernel_event = sycl_queue.submit([&](sycl::handler& cgh) {
-    auto reduce_normy = sycl::reduction(normy, sycl::plus<>());
-    cgh.parallel_for(kernel_range, reduce_normy,
-                     [=](sycl::id<1> i, auto& normy_) {
-                       T y_i = alpha * x[i] + y[i];
-                       y[i] = y_i;
-                       normy_ += y_i * y_i;
-                     });
-  });
-  return kernel_event;
-}
+struct results_t {
+  double cold_start;  // host time of the first launch (ms)
+  timing::timings_t latency;
+  timing::throughput_t throughput;  // only if window > 0
+};
 
-template <typename T, bool is_fused>
-std::vector<double> runBenchmark(sycl::queue& sycl_queue, int64_t N,
-                                 size_t number_of_trials) {
+// Times the first launch, which also verifies the result, then trials one at
+// a time, waiting for each, and then, if window > 0, back-to-back with up to
+// window trials in flight. Kernels are launched from kernel_bundle if it is
+// given; otherwise the first launch in the program includes JIT compilation.
+// If sub_group_size is not 0, the fused kernel reduces within sub-groups of
+// that size instead of with sycl::reduction.
+template <typename T, bool is_fused, int sub_group_size = 0>
+results_t runBenchmark(sycl::queue& sycl_queue,
+                       memory_pool::device_pool_t& pool, int64_t N,
+                       size_t number_of_trials, size_t window,
+                       const bundle::executable_t* kernel_bundle) {
   const T alpha = 1.0;
-  T* x = sycl::malloc_device<T>(N, sycl_queue);
-  T* y = sycl::malloc_device<T>(N, sycl_queue);
-  T* normy = sycl::malloc_device<T>(1, sycl_queue);
+  T* x = pool.allocate<T>(N);
+  T* y = pool.allocate<T>(N);
+  T* normy = pool.allocate<T>(1);
 
-  sycl_queue.fill(x, T(1.0), N);
-  sycl_queue.fill(y, T(1.0), N);
+  // Verify one call against the host result before timing
+  std::vector<T> x_host(N);
+  std::vector<T> y_host(N);
+  for (int64_t i = 0; i < N; ++i) {
+    x_host[i] = T(i % 7) - T(3);
+    y_host[i] = T(i % 5) - T(2);
+  }
+  sycl_queue.copy(x_host.data(), x, N);
+  sycl_queue.copy(y_host.data(), y, N);
   sycl_queue.fill(normy, T(0.0), 1);
   sycl_queue.wait();
 
-  std::vector<double> runtimes(number_of_trials);
-  for (auto& runtime : runtimes) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    if (!is_fused) {
-      axpyDot(sycl_queue, N, alpha, x, y, normy).wait();
+  results_t results{};
+  auto launch = [&](const std::vector<sycl::event>& dependencies) {
+    if constexpr (!is_fused) {
+      return axpyDot(sycl_queue, N, alpha, x, y, normy, dependencies,
+                     kernel_bundle);
+    } else if constexpr (0 < sub_group_size) {
+      return std::vector<sycl::event>{axpyDotSubGroup<sub_group_size>(
+          sycl_queue, N, alpha, x, y, normy, dependencies, kernel_bundle)};
     } else {
-      axpyDotFused(sycl_queue, N, alpha, x, y, normy).wait();
+      return std::vector<sycl::event>{axpyDotFused(
+          sycl_queue, N, alpha, x, y, normy, dependencies, kernel_bundle)};
     }
+  };
 
-    auto finish_time = std::chrono::high_resolution_clock::now();
-    runtime =
-        std::chrono::duration<double, std::milli>(finish_time - start_time)
-            .count();
+  auto start_time = std::chrono::high_resolution_clock::now();
+  sycl::event::wait(launch({}));
+  auto finish_time = std::chrono::high_resolution_clock::now();
+  results.cold_start =
+      std::chrono::duration<double, std::milli>(finish_time - start_time)
+          .count();
+
+  T normy_result{};
+  sycl_queue.copy(normy, &normy_result, 1).wait();
+  host_blas::axpy(N, alpha, x_host.data(), y_host.data());
+  const T normy_valid = host_blas::dot(N, y_host.data(), y_host.data());
+  if (std::abs(normy_result - normy_valid) > 1.0e-4 * normy_valid) {
+    std::cout << "Verification failed!\n";
+    std::cout << "expected: " << normy_valid << "\n";
+    std::cout << "actual: " << normy_result << "\n";
+    exit(EXIT_FAILURE);
+  }
+
+  sycl_queue.fill(x, T(1.0), N);
+  sycl_queue.fill(y, T(1.0), N);
+  sycl_queue.fill(normy, T(0.0), 1);
+  sycl_queue.wait();
+
+  results.latency = timing::timeTrials(sycl_queue, number_of_trials,
+                                       [&]() { return launch({}); });
+  if (0 < window) {
+    results.throughput =
+        timing::timeThroughput(sycl_queue, number_of_trials, window, launch);
   }
 
-  sycl::free(x, sycl_queue);
-  sycl::free(y, sycl_queue);
-  sycl::free(normy, sycl_queue);
+  pool.deallocate(x);
+  pool.deallocate(y);
+  pool.deallocate(normy);
 
-  return runtimes;
+  return results;
 }
 
+// Times the chain z = a * x + b * y; w = z .* v; s = w^T r, built from
+// expressions. Unfused, each step is its own kernel and z and w go through
+// memory between them. Fused, evaluate() compiles all three into one kernel
+// which still writes z and w, but reads x, y, v and r only once and never
+// reads back z or w.
+template <typename T, bool is_fused>
+timing::timings_t runChainBenchmark(sycl::queue& sycl_queue,
+                                    memory_pool::device_pool_t& pool,
+                                    int64_t N, size_t number_of_trials) {
+  const T a = 2.0;
+  const T b = -1.0;
+  T* x = pool.allocate<T>(N);
+  T* y = pool.allocate<T>(N);
+  T* v = pool.allocate<T>(N);
+  T* r = pool.allocate<T>(N);
+  T* z = pool.allocate<T>(N);
+  T* w = pool.allocate<T>(N);
+  T* s = pool.allocate<T>(1);
+
+  std::vector<T> x_host(N), y_host(N), v_host(N), r_host(N);
+  for (int64_t i = 0; i < N; ++i) {
+    x_host[i] = T(i % 7) - T(3);
+    y_host[i] = T(i % 5) - T(2);
+    v_host[i] = T(i % 3) - T(1);
+    r_host[i] = T(i % 4) - T(2);
+  }
+  sycl_queue.copy(x_host.data(), x, N);
+  sycl_queue.copy(y_host.data(), y, N);
+  sycl_queue.copy(v_host.data(), v, N);
+  sycl_queue.copy(r_host.data(), r, N);
+  sycl_queue.wait();
+
+  auto x_ = expr::vector<const T>(x, N);
+  auto y_ = expr::vector<const T>(y, N);
+  auto v_ = expr::vector<const T>(v, N);
+  auto r_ = expr::vector<const T>(r, N);
+  auto z_ = expr::vector(z, N);
+  auto w_ = expr::vector(w, N);
+
+  auto launch = [&]() {
+    if (is_fused) {
+      auto z_expression = a * x_ + b * y_;
+      auto w_expression = z_expression * v_;
+      return std::vector<sycl::event>{expr::evaluate(
+          sycl_queue, N,
+          std::tuple{expr::assign(z_, z_expression),
+                     expr::assign(w_, w_expression)},
+          std::tuple{expr::dot(s, w_expression, r_)})};
+    }
+    sycl::event z_event = expr::evaluate(
+        sycl_queue, N, std::tuple{expr::assign(z_, a * x_ + b * y_)});
+    sycl::event w_event = expr::evaluate(
+        sycl_queue, N, std::tuple{expr::assign(w_, z_ * v_)}, {z_event});
+    sycl::event s_event =
+        expr::evaluate(sycl_queue, N, std::tuple<>(),
+                       std::tuple{expr::dot(s, w_, r_)}, {w_event});
+    return std::vector<sycl::event>{z_event, w_event, s_event};
+  };
+
+  sycl::event::wait(launch());
+  T s_result{};
+  sycl_queue.copy(s, &s_result, 1).wait();
+  T s_valid{};
+  for (int64_t i = 0; i < N; ++i) {
+    s_valid += (a * x_host[i] + b * y_host[i]) * v_host[i] * r_host[i];
+  }
+  if (std::abs(s_result - s_valid) > 1.0e-4 * std::abs(s_valid)) {
+    std::cout << "Verification failed!\n";
+    std::cout << "expected: " << s_valid << "\n";
+    std::cout << "actual: " << s_result << "\n";
+    exit(EXIT_FAILURE);
+  }
+
+  auto timings = timing::timeTrials(sycl_queue, number_of_trials, launch);
+
+  for (T* ptr : {x, y, v, r, z, w, s}) pool.deallocate(ptr);
+  return timings;
 }
 
+}  // namespace
+
 int main(int argc, char* argv[]) {
   auto arguments = readArguments(argc,argv);
   printArguments(arguments);
@@ -95,20 +198,152 @@ int main(int argc, char* argv[]) {
 
   sycl::device sycl_device{sycl::default_selector()};
   sycl::context sycl_context{sycl_device};
-  sycl::queue sycl_queue{sycl_context, sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
 
-  auto unfused_times =
-      runBenchmark<float, false>(sycl_queue, N, number_of_trials);
-  auto fused_times =
-      runBenchmark<float, true>(sycl_queue, N, number_of_trials);
+  // Build the kernels before the first launch, unless measuring the cost of
+  // compiling them lazily
+  std::unique_ptr<bundle::executable_t> kernel_bundle;
+  double build_time = 0.0;
+  if (!arguments.lazy_jit) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    kernel_bundle =
+        std::make_unique<bundle::executable_t>(bundle::build(sycl_queue));
+    auto finish_time = std::chrono::high_resolution_clock::now();
+    build_time =
+        std::chrono::duration<double, std::milli>(finish_time - start_time)
+            .count();
+  }
 
-  auto unfused_stats = stats::computeStats(unfused_times, "ms");
-  auto fused_stats = stats::computeStats(fused_times, "ms");
+  // Repeated runs allocate the same sizes, so the pool can reuse its blocks.
+  // Statistics are reported for the last run, and cold-start latency for the
+  // first.
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+  results_t unfused_results;
+  results_t fused_results;
+  double unfused_cold_start = 0.0;
+  double fused_cold_start = 0.0;
+  for (size_t run = 0; run < arguments.runs; ++run) {
+    unfused_results =
+        runBenchmark<float, false>(sycl_queue, pool, N, number_of_trials,
+                                   arguments.window, kernel_bundle.get());
+    fused_results =
+        runBenchmark<float, true>(sycl_queue, pool, N, number_of_trials,
+                                  arguments.window, kernel_bundle.get());
+    if (0 == run) {
+      unfused_cold_start = unfused_results.cold_start;
+      fused_cold_start = fused_results.cold_start;
+    }
+  }
+  memory_pool::printStats(pool.stats());
 
-  std::cout << "Unfused Kernel Times\n";
-  stats::printStats(unfused_stats);
-  std::cout << "Fused Kernel Times\n";
-  stats::printStats(fused_stats);
+  std::cout << "Cold Start\n";
+  if (kernel_bundle) {
+    std::cout << "kernel bundle build: " << std::scientific
+              << std::setprecision(6) << build_time << " ms\n";
+  }
+  std::cout << "unfused first launch: " << std::scientific
+            << std::setprecision(6) << unfused_cold_start << " ms\n";
+  std::cout << "fused first launch: " << fused_cold_start << " ms\n\n";
+
+  const stats::options_t stats_options{arguments.warmup,
+                                       arguments.outlier_threshold};
+  auto unfused_stats =
+      timing::computeStats(unfused_results.latency, stats_options);
+  auto fused_stats = timing::computeStats(fused_results.latency, stats_options);
+
+  std::cout << "Unfused Kernel Times (warm)\n";
+  timing::printStats(unfused_stats);
+  std::cout << "Fused Kernel Times (warm)\n";
+  timing::printStats(fused_stats);
+
+  // The unfused kernels read x and y, write y and read y again. The fused
+  // kernel reads y only once.
+  const double unfused_bytes = 4.0 * sizeof(float) * N;
+  const double fused_bytes = 3.0 * sizeof(float) * N;
+  std::vector<std::pair<std::string, double>> unfused_metrics{
+      {"cold_start_ms", unfused_cold_start}, {"bundle_build_ms", build_time}};
+  std::vector<std::pair<std::string, double>> fused_metrics{
+      {"cold_start_ms", fused_cold_start}, {"bundle_build_ms", build_time}};
+  if (0 < arguments.window) {
+    std::cout << "Unfused Kernel Throughput\n";
+    timing::printThroughput(unfused_results.throughput, unfused_stats,
+                            unfused_bytes);
+    std::cout << "Fused Kernel Throughput\n";
+    timing::printThroughput(fused_results.throughput, fused_stats,
+                            fused_bytes);
+    for (const auto& metric : timing::throughputMetrics(
+             unfused_results.throughput, unfused_bytes)) {
+      unfused_metrics.push_back(metric);
+    }
+    for (const auto& metric :
+         timing::throughputMetrics(fused_results.throughput, fused_bytes)) {
+      fused_metrics.push_back(metric);
+    }
+  }
+
+  // The fused kernel again, reduced within sub-groups, for each sub-group
+  // size the device supports
+  std::vector<std::pair<std::string, timing::timing_stats_t>> sub_group_stats;
+  device_blas::forEachSubGroupSize(sycl_device, [&](auto size) {
+    constexpr int sub_group_size = decltype(size)::value;
+    auto results = runBenchmark<float, true, sub_group_size>(
+        sycl_queue, pool, N, number_of_trials, 0, kernel_bundle.get());
+    auto kernel_stats = timing::computeStats(results.latency, stats_options);
+    std::cout << "Sub-Group Fused Kernel Times, Sub-Group Size "
+              << sub_group_size << " (warm)\n";
+    timing::printStats(kernel_stats);
+    std::cout << "Bandwidth: " << std::fixed
+              << (fused_bytes / kernel_stats.kernel().mean) * 1.0e-6
+              << " GB/s\n";
+    std::cout << "Speedup over fused: "
+              << fused_stats.kernel().mean / kernel_stats.kernel().mean
+              << "\n\n";
+    sub_group_stats.emplace_back(
+        "sub_group_" + std::to_string(sub_group_size), kernel_stats);
+  });
+
+  auto chain_unfused_times =
+      runChainBenchmark<float, false>(sycl_queue, pool, N, number_of_trials);
+  auto chain_fused_times =
+      runChainBenchmark<float, true>(sycl_queue, pool, N, number_of_trials);
+  auto chain_unfused_stats =
+      timing::computeStats(chain_unfused_times, stats_options);
+  auto chain_fused_stats =
+      timing::computeStats(chain_fused_times, stats_options);
+
+  // Unfused: x, y and z are moved by the first kernel, z, v and w by the
+  // second, and w and r by the third. Fused: x, y, v, r, z and w once each.
+  const double chain_unfused_bytes = 8.0 * sizeof(float) * N;
+  const double chain_fused_bytes = 6.0 * sizeof(float) * N;
+  std::cout << "Unfused Expression Chain Times (warm)\n";
+  timing::printStats(chain_unfused_stats);
+  std::cout << "Bandwidth: " << std::fixed
+            << (chain_unfused_bytes / chain_unfused_stats.kernel().mean) *
+                   1.0e-6
+            << " GB/s\n\n";
+  std::cout << "Fused Expression Chain Times (warm)\n";
+  timing::printStats(chain_fused_stats);
+  std::cout << "Bandwidth: " << std::fixed
+            << (chain_fused_bytes / chain_fused_stats.kernel().mean) * 1.0e-6
+            << " GB/s\n\n";
+
+  if (!arguments.stats_file.empty()) {
+    std::vector<stats::record_t<double>> records;
+    timing::appendRecords(records, "unfused", unfused_stats, unfused_metrics);
+    timing::appendRecords(records, "fused", fused_stats, fused_metrics);
+    for (const auto& [name, kernel_stats] : sub_group_stats) {
+      timing::appendRecords(records, name, kernel_stats);
+    }
+    timing::appendRecords(records, "chain_unfused", chain_unfused_stats);
+    timing::appendRecords(records, "chain_fused", chain_fused_stats);
+    if (!stats::writeRecords(arguments.stats_file, records)) {
+      return EXIT_FAILURE;
+    }
+  }
 
   return EXIT_SUCCESS;
 }
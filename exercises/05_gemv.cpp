@@ -1,44 +1,550 @@
 #include <CL/sycl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#include "device_blas.hpp"
 #include "gemv.hpp"
+#include "host_blas.hpp"
+#include "matrix_io.hpp"
+#include "memory_pool.hpp"
+#include "precision.hpp"
+#include "staging.hpp"
 #include "stats.hpp"
+#include "timing.hpp"
+
+// Aliasing oneAPI DPC++ specific extensions
+namespace dpcpp = sycl::ext::oneapi;
 
 namespace {
 
-// Naive implementation of GEMV function for verification purposes.
-// Computes y = alpha * A(x) + beta * y
-template <typename T>
-void gemv(int64_t m, int64_t n, T alpha, const T* a, const T* x, T beta, T* y) {
-  for (int64_t i = 0; i < m; ++i) {
-    y[i] *= beta;
+using device_blas::launchGemv;
+using host_blas::transpose;
+
+// Settings shared by all benchmarks, and the statistics they record
+struct benchmark_t {
+  size_t number_of_trials;
+  stats::options_t stats_options;
+  size_t window;  // trials in flight when timing throughput, 0 to skip
+  memory_pool::device_pool_t& pool;
+  std::vector<stats::record_t<double>> records{};
+};
+
+// If a window is set, time launch(dependencies) back-to-back with that many
+// trials in flight, print it next to the latency in kernel_stats, and add
+// the throughput to metrics.
+template <typename F>
+void runThroughput(sycl::queue& sycl_queue, const benchmark_t& benchmark,
+                   F launch, const timing::timing_stats_t& kernel_stats,
+                   double bytes,
+                   std::vector<std::pair<std::string, double>>& metrics) {
+  if (0 == benchmark.window) return;
+  auto throughput = timing::timeThroughput(
+      sycl_queue, benchmark.number_of_trials, benchmark.window, launch);
+  timing::printThroughput(throughput, kernel_stats, bytes);
+  auto throughput_metrics = timing::throughputMetrics(throughput, bytes);
+  metrics.insert(metrics.end(), throughput_metrics.begin(),
+                 throughput_metrics.end());
+}
+
+// Launches the kernel selected by is_tiled, or the sub-group kernel if
+// sub_group_size is not 0
+template <typename T, typename Tacc, bool is_tiled, int sub_group_size>
+sycl::event launchKernel(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                         int64_t n, Tacc alpha, const T* a, const T* x,
+                         Tacc beta, Tacc* y,
+                         const std::vector<sycl::event>& dependencies) {
+  if constexpr (0 < sub_group_size) {
+    return device_blas::gemvSubGroup<sub_group_size>(
+        sycl_queue, trans, m, n, alpha, a, x, beta, y, dependencies);
+  } else {
+    return launchGemv<T, Tacc, is_tiled>(sycl_queue, trans, m, n, alpha, a,
+                                         x, beta, y, dependencies);
+  }
+}
+
+// Name of the kernel launched by launchKernel
+template <bool is_tiled, int sub_group_size>
+std::string kernelName() {
+  if (0 < sub_group_size) {
+    return "sub_group_" + std::to_string(sub_group_size);
   }
+  return is_tiled ? "tiled" : "naive";
+}
 
-  for (int64_t j = 0; j < n; ++j) {
-    T x_j = x[j];
-    for (int64_t i = 0; i < m; ++i) {
-      // The sum of the columns of A weighted by alpha * x[j];
-      y[i] += alpha * a[i + m * j] * x_j;
-    }
+// Verify a device kernel, with A and x stored as T and arithmetic done in
+// Tacc, then time it. y_valid is the result computed in float from the
+// unrounded inputs, and y_scale bounds the size of the terms summed to give
+// each entry: |alpha| * |A||x| + |beta| * |y|. Returns false if verification
+// fails.
+template <typename T, typename Tacc, bool is_tiled, int sub_group_size = 0>
+bool runBenchmark(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                  int64_t n, benchmark_t& benchmark, float alpha, float beta,
+                  matrix_io::array_view_t<float> A_host,
+                  matrix_io::array_view_t<float> x_host,
+                  matrix_io::array_view_t<float> y_host,
+                  const std::vector<float>& y_valid,
+                  const std::vector<float>& y_scale) {
+  std::cout << "Kernel: " << kernelName<is_tiled, sub_group_size>()
+            << ", Storage: "
+            << precision::traits<T>::name
+            << ", Accumulation: " << precision::traits<Tacc>::name << "\n";
+
+  const int64_t x_size = x_host.size();
+  const int64_t y_size = y_host.size();
+
+  // A is only converted if it is stored in a different type; otherwise it is
+  // uploaded straight from A_host, e.g. from a mapped input file.
+  std::vector<T> A_storage;
+  const T* A_source = nullptr;
+  if constexpr (std::is_same<T, float>::value) {
+    A_source = A_host.data();
+  } else {
+    A_storage = precision::convert<T>(A_host);
+    A_source = A_storage.data();
+  }
+  std::vector<T> x_storage = precision::convert<T>(x_host);
+  std::vector<Tacc> y_storage = precision::convert<Tacc>(y_host);
+
+  T* A = benchmark.pool.allocate<T>(A_host.size());
+  T* x = benchmark.pool.allocate<T>(x_size);
+  Tacc* y = benchmark.pool.allocate<Tacc>(y_size);
+
+  sycl::event copy_A = sycl_queue.copy(A_source, A, A_host.size());
+  sycl::event copy_x = sycl_queue.copy(x_storage.data(), x, x_size);
+  sycl::event copy_y = sycl_queue.copy(y_storage.data(), y, y_size);
+  sycl::event gemv_kernel = launchKernel<T, Tacc, is_tiled, sub_group_size>(
+      sycl_queue, trans, m, n, Tacc(alpha), A, x, Tacc(beta), y,
+      {copy_A, copy_x, copy_y});
+
+  std::vector<Tacc> y_result(y_size);
+  sycl_queue.copy(y, y_result.data(), y_size, {gemv_kernel}).wait();
+
+  // Error in a sum of k terms is bounded by k * epsilon of Tacc, which is
+  // above 1 for half once k > 2048. The entries are random, so the rounding
+  // errors are independent and grow like sqrt(k) * epsilon; allow four times
+  // that, plus the rounding of the result. The float host reference gets the
+  // worst-case bound, which stays small. Rounding A and x to T changes each
+  // product by up to about 2 * epsilon of T.
+  const double k = x_size;
+  const double tolerance =
+      (4.0 * std::sqrt(k) + 1.0) * precision::traits<Tacc>::epsilon +
+      (k + 2.0) * precision::traits<float>::epsilon +
+      2.0 * precision::traits<T>::epsilon;
+  bool is_valid = precision::verify(y_valid, y_result, y_scale, tolerance);
+
+  if (is_valid) {
+    // Now run and time the kernel
+    auto launch = [&](const std::vector<sycl::event>& dependencies) {
+      return launchKernel<T, Tacc, is_tiled, sub_group_size>(
+          sycl_queue, trans, m, n, Tacc(alpha), A, x, Tacc(beta), y,
+          dependencies);
+    };
+    auto times = timing::timeTrials(sycl_queue, benchmark.number_of_trials,
+                                    [&]() { return launch({}); });
+
+    // A is read once, x is read at least once, y is read and written
+    const double bytes = sizeof(T) * double(m * n + x_size) +
+                         sizeof(Tacc) * double(2 * y_size);
+
+    auto kernel_stats = timing::computeStats(times, benchmark.stats_options);
+    const double bandwidth = (bytes / kernel_stats.kernel().mean) * 1.0e-6;
+    const double error = precision::maxRelativeError(y_valid, y_result);
+    timing::printStats(kernel_stats);
+    std::cout << "Bandwidth: " << std::fixed << bandwidth << " GB/s\n";
+    std::cout << "Max relative error: " << std::scientific << error
+              << "\n\n";
+
+    const std::string name = kernelName<is_tiled, sub_group_size>() + "_" +
+                             precision::traits<T>::name + "_" +
+                             precision::traits<Tacc>::name;
+    std::vector<std::pair<std::string, double>> metrics{
+        {"bandwidth_gbps", bandwidth}, {"max_error", error}};
+    runThroughput(sycl_queue, benchmark, launch, kernel_stats, bytes,
+                  metrics);
+    timing::appendRecords(benchmark.records, name, kernel_stats, metrics);
+  }
+
+  benchmark.pool.deallocate(A);
+  benchmark.pool.deallocate(x);
+  benchmark.pool.deallocate(y);
+  return is_valid;
+}
+
+// Run a kernel for each pair of storage and accumulation types
+template <bool is_tiled, int sub_group_size = 0>
+bool runPrecisions(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                   int64_t n, benchmark_t& benchmark, float alpha,
+                   float beta, matrix_io::array_view_t<float> A_host,
+                   matrix_io::array_view_t<float> x_host,
+                   matrix_io::array_view_t<float> y_host,
+                   const std::vector<float>& y_valid,
+                   const std::vector<float>& y_scale) {
+  bool is_valid = runBenchmark<float, float, is_tiled, sub_group_size>(
+      sycl_queue, trans, m, n, benchmark, alpha, beta, A_host, x_host,
+      y_host, y_valid, y_scale);
+  if (sycl_queue.get_device().has(sycl::aspect::fp16)) {
+    is_valid &= runBenchmark<sycl::half, float, is_tiled, sub_group_size>(
+        sycl_queue, trans, m, n, benchmark, alpha, beta, A_host,
+        x_host, y_host, y_valid, y_scale);
+    is_valid &= runBenchmark<sycl::half, sycl::half, is_tiled, sub_group_size>(
+        sycl_queue, trans, m, n, benchmark, alpha, beta, A_host,
+        x_host, y_host, y_valid, y_scale);
+  } else {
+    std::cout << "Device does not support half precision.\n\n";
   }
+  return is_valid;
 }
 
-template <typename T>
-sycl::event gemv(sycl::queue& sycl_queue, int64_t m, int64_t n, T alpha,
-                 const T* a, const T* x, T beta, T* y,
-                 const std::vector<sycl::event>& dependencies = {}) {
-  sycl::range<1> kernel_range(m);
-  sycl::event gemv_event =
-      sycl_queue.parallel_for(kernel_range, dependencies, [=](sycl::id<1> i) {
-        T y_i = beta * y[i];
-        for (int64_t j = 0; j < n; ++j) {
-          y_i += alpha * a[i + m * j] * x[j];
+enum class batch_mode { loop, strided, pointer_array };
+
+// Verify and time a batch of gemvs computed either by looping over single
+// gemv launches, or by one of the gemv_batch variants. Returns false if
+// verification fails.
+template <typename T, batch_mode mode>
+bool runBatchBenchmark(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                       int64_t n, int64_t batch_size, benchmark_t& benchmark,
+                       T alpha, const T* a, const T* x, T beta, T* y,
+                       matrix_io::array_view_t<T> y_host,
+                       const std::vector<T>& y_valid,
+                       const std::vector<T>& y_scale) {
+  const int64_t x_size = (transpose::nontrans == trans) ? n : m;
+  const int64_t y_size = (transpose::nontrans == trans) ? m : n;
+  const int64_t stride_a = m * n;
+
+  // Pointer arrays for the gemv_batch variant which takes them
+  std::vector<const T*> a_pointers(batch_size);
+  std::vector<const T*> x_pointers(batch_size);
+  std::vector<T*> y_pointers(batch_size);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    a_pointers[b] = a + stride_a * b;
+    x_pointers[b] = x + x_size * b;
+    y_pointers[b] = y + y_size * b;
+  }
+  const T** a_array = benchmark.pool.allocate<const T*>(batch_size);
+  const T** x_array = benchmark.pool.allocate<const T*>(batch_size);
+  T** y_array = benchmark.pool.allocate<T*>(batch_size);
+  sycl_queue.copy(a_pointers.data(), a_array, batch_size);
+  sycl_queue.copy(x_pointers.data(), x_array, batch_size);
+  sycl_queue.copy(y_pointers.data(), y_array, batch_size);
+  sycl_queue.wait();
+
+  auto launch = [&](const std::vector<sycl::event>& dependencies) {
+    std::vector<sycl::event> gemv_events;
+    switch (mode) {
+      case batch_mode::loop:
+        for (int64_t b = 0; b < batch_size; ++b) {
+          gemv_events.push_back(device_blas::gemv(
+              sycl_queue, trans, m, n, alpha, a_pointers[b], x_pointers[b],
+              beta, y_pointers[b], dependencies));
         }
-        y[i] = y_i;
-      });
-  return gemv_event;
+        break;
+      case batch_mode::strided:
+        gemv_events.push_back(device_blas::gemv_batch(
+            sycl_queue, trans, m, n, alpha, a, stride_a, x, x_size, beta, y,
+            y_size, batch_size, dependencies));
+        break;
+      default:
+        gemv_events.push_back(device_blas::gemv_batch(
+            sycl_queue, trans, m, n, alpha, a_array, x_array, beta, y_array,
+            batch_size, dependencies));
+    }
+    return gemv_events;
+  };
+
+  std::vector<T> y_result(y_host.size());
+  sycl::event copy_y = sycl_queue.copy(y_host.data(), y, y_host.size());
+  auto gemv_events = launch({copy_y});
+  sycl_queue.copy(y, y_result.data(), y_result.size(), gemv_events).wait();
+
+  // As in runBenchmark: rounding errors of the device sum grow like
+  // sqrt(k) * epsilon, and the host reference is within the worst-case bound
+  const double k = x_size;
+  const double tolerance =
+      (4.0 * std::sqrt(k) + 1.0) * precision::traits<T>::epsilon +
+      (k + 2.0) * precision::traits<float>::epsilon;
+  bool is_valid = precision::verify(y_valid, y_result, y_scale, tolerance);
+
+  if (is_valid) {
+    auto times = timing::timeTrials(sycl_queue, benchmark.number_of_trials,
+                                    [&]() { return launch({}); });
+
+    const double bytes =
+        sizeof(T) * double(batch_size * (m * n + x_size + 2 * y_size));
+
+    auto kernel_stats = timing::computeStats(times, benchmark.stats_options);
+    const double bandwidth = (bytes / kernel_stats.kernel().mean) * 1.0e-6;
+    std::string name;
+    switch (mode) {
+      case batch_mode::loop:
+        std::cout << "Looped gemv Times\n";
+        name = "batch_loop";
+        break;
+      case batch_mode::strided:
+        std::cout << "Strided gemv_batch Times\n";
+        name = "batch_strided";
+        break;
+      default:
+        std::cout << "Pointer Array gemv_batch Times\n";
+        name = "batch_pointer_array";
+    }
+    timing::printStats(kernel_stats);
+    std::cout << "Bandwidth: " << std::fixed << bandwidth << " GB/s\n\n";
+    std::vector<std::pair<std::string, double>> metrics{
+        {"bandwidth_gbps", bandwidth}};
+    runThroughput(sycl_queue, benchmark, launch, kernel_stats, bytes,
+                  metrics);
+    timing::appendRecords(benchmark.records, name, kernel_stats, metrics);
+  }
+
+  benchmark.pool.deallocate(a_array);
+  benchmark.pool.deallocate(x_array);
+  benchmark.pool.deallocate(y_array);
+  return is_valid;
+}
+
+// Times uploading A and running the tiled kernel, end to end. Without
+// staging, A is copied whole from A_host before the kernel starts. With
+// staging, A is copied chunk_columns columns at a time through a pair of
+// pinned buffers, and a kernel computes the contribution of each panel of
+// columns once it has arrived, overlapping with the copy of the next one.
+// Returns false if verification fails.
+template <bool is_staged>
+bool runTransferBenchmark(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                          int64_t n, int64_t chunk_columns,
+                          benchmark_t& benchmark, float alpha, float beta,
+                          matrix_io::array_view_t<float> A_host,
+                          matrix_io::array_view_t<float> x_host,
+                          matrix_io::array_view_t<float> y_host,
+                          const std::vector<float>& y_valid) {
+  float* A = benchmark.pool.allocate<float>(A_host.size());
+  float* x = benchmark.pool.allocate<float>(x_host.size());
+  float* y = benchmark.pool.allocate<float>(y_host.size());
+
+  staging::ring_t ring{sycl_queue, sizeof(float) * m * chunk_columns};
+
+  auto launch = [&]() {
+    sycl::event copy_x = sycl_queue.copy(x_host.data(), x, x_host.size());
+    sycl::event copy_y = sycl_queue.copy(y_host.data(), y, y_host.size());
+    if (!is_staged) {
+      sycl::event copy_A = sycl_queue.copy(A_host.data(), A, A_host.size());
+      return std::vector<sycl::event>{launchGemv<float, float, true>(
+          sycl_queue, trans, m, n, alpha, A, x, beta, y,
+          {copy_A, copy_x, copy_y})};
+    }
+
+    // Columns j0 to j0 + n0 of A contribute to all of y in the non-transposed
+    // case, so those kernels accumulate into y one after the other. In the
+    // transposed case they give entries j0 to j0 + n0 of y independently.
+    sycl::event previous = copy_y;
+    return staging::upload(
+        ring, A_host.data(), A, A_host.size(), m * chunk_columns,
+        [&](size_t offset, size_t count, sycl::event copy_A) {
+          const int64_t j0 = offset / m;
+          const int64_t n0 = count / m;
+          if (transpose::nontrans == trans) {
+            previous = launchGemv<float, float, true>(
+                sycl_queue, trans, m, n0, alpha, A + offset, x + j0,
+                (0 == j0) ? beta : 1.0f, y, {copy_A, copy_x, previous});
+            return previous;
+          }
+          return launchGemv<float, float, true>(
+              sycl_queue, trans, m, n0, alpha, A + offset, x, beta, y + j0,
+              {copy_A, copy_x, copy_y});
+        });
+  };
+
+  std::vector<float> y_result(y_host.size());
+  sycl_queue.copy(y, y_result.data(), y_result.size(), launch()).wait();
+
+  // All entries are in [-1, 1], so each sum of k terms is bounded by
+  // |alpha| * k + |beta|
+  const int64_t k = x_host.size();
+  std::vector<float> y_scale(y_host.size(),
+                             std::abs(alpha) * k + std::abs(beta));
+  const double tolerance = 2.0 * (k + 2) * precision::traits<float>::epsilon;
+  bool is_valid = precision::verify(y_valid, y_result, y_scale, tolerance);
+
+  if (is_valid) {
+    auto times = timing::timeTrials(sycl_queue, benchmark.number_of_trials,
+                                    launch);
+    auto transfer_stats =
+        timing::computeStats(times, benchmark.stats_options);
+    const double bytes =
+        sizeof(float) * double(A_host.size() + x_host.size() + y_host.size());
+    const double bandwidth =
+        (bytes / transfer_stats.kernel().mean) * 1.0e-6;
+
+    std::cout << (is_staged ? "Staged" : "Unstaged")
+              << " Copy + Tiled gemv Times\n";
+    timing::printStats(transfer_stats);
+    std::cout << "Host to device bandwidth: " << std::fixed << bandwidth
+              << " GB/s\n\n";
+    timing::appendRecords(benchmark.records,
+                          is_staged ? "staged_copy" : "unstaged_copy",
+                          transfer_stats, {{"bandwidth_gbps", bandwidth}});
+  }
+
+  benchmark.pool.deallocate(A);
+  benchmark.pool.deallocate(x);
+  benchmark.pool.deallocate(y);
+  return is_valid;
+}
+
+// Computes y = alpha * op(A)(x) + beta * y with A in host memory, for
+// matrices which do not fit on the device. A is streamed in panels of
+// panel_columns columns: each panel is copied through ring into one of the
+// device buffers in panels, and a kernel computes its contribution to y. A
+// buffer is refilled once the kernel reading it has completed, so copies of
+// the next panels overlap with the kernel on the current one.
+std::vector<sycl::event> gemvStreamed(
+    sycl::queue& sycl_queue, staging::ring_t& ring,
+    const std::vector<float*>& panels, int64_t panel_columns, transpose trans,
+    int64_t m, int64_t n, float alpha, const float* a_host, const float* x,
+    float beta, float* y, const std::vector<sycl::event>& dependencies = {}) {
+  // The last kernel to read each device buffer
+  std::vector<sycl::event> panel_events(panels.size());
+  std::vector<sycl::event> gemv_events;
+  std::vector<sycl::event> previous = dependencies;
+
+  for (int64_t j0 = 0, p = 0; j0 < n; j0 += panel_columns, ++p) {
+    const int64_t n0 = std::min(panel_columns, n - j0);
+    const size_t b = p % panels.size();
+    sycl::event copy_panel =
+        ring.stage(a_host + m * j0, panels[b], m * n0, {panel_events[b]});
+
+    std::vector<sycl::event> gemv_dependencies = dependencies;
+    gemv_dependencies.push_back(copy_panel);
+    if (transpose::nontrans == trans) {
+      // Every panel contributes to all of y, one after the other
+      gemv_dependencies.insert(gemv_dependencies.end(), previous.begin(),
+                               previous.end());
+      panel_events[b] = launchGemv<float, float, true>(
+          sycl_queue, trans, m, n0, alpha, panels[b], x + j0,
+          (0 == j0) ? beta : 1.0f, y, gemv_dependencies);
+      previous = {panel_events[b]};
+    } else {
+      // Each panel gives its own entries of y
+      panel_events[b] = launchGemv<float, float, true>(
+          sycl_queue, trans, m, n0, alpha, panels[b], x, beta, y + j0,
+          gemv_dependencies);
+      gemv_events.push_back(panel_events[b]);
+    }
+  }
+  return (transpose::nontrans == trans) ? previous : gemv_events;
+}
+
+// Streams matrices with m rows and from a quarter to four times as many
+// bytes as the device memory budget through gemvStreamed, reporting the
+// sustained bandwidth of each. Device memory for x, y and two panel buffers
+// stays within the budget. Returns false if verification fails.
+bool runStreamingBenchmark(sycl::queue& sycl_queue, transpose trans,
+                           int64_t m, double memory_budget,
+                           benchmark_t& benchmark, float alpha, float beta,
+                           std::mt19937_64& generator) {
+  constexpr int number_of_panels{2};
+  // Every trial moves the whole matrix from the host
+  const size_t number_of_trials =
+      std::min<size_t>(benchmark.number_of_trials, 20);
+  std::uniform_real_distribution<float> distribution(-1.0, 1.0);
+
+  std::cout << "Streamed Tiled gemv, Budget: " << memory_budget
+            << " bytes\n";
+  std::cout << std::setw(12) << "A/budget" << std::setw(12) << "columns"
+            << std::setw(10) << "panel" << std::setw(15) << "time (ms)"
+            << std::setw(12) << "GB/s"
+            << "\n";
+
+  bool is_valid = true;
+  for (double ratio : {0.25, 0.5, 1.0, 2.0, 4.0}) {
+    const int64_t n = std::max<int64_t>(
+        1, ratio * memory_budget / (sizeof(float) * m));
+    const int64_t x_size = (transpose::nontrans == trans) ? n : m;
+    const int64_t y_size = (transpose::nontrans == trans) ? m : n;
+
+    // What is left of the budget after x and y holds the panels
+    const double panel_budget =
+        memory_budget - sizeof(float) * double(x_size + y_size);
+    const int64_t panel_columns = std::min<int64_t>(
+        n, panel_budget / (number_of_panels * sizeof(float) * m));
+    if (1 > panel_columns) {
+      std::cout << "Memory budget is too small for one column of A.\n";
+      return false;
+    }
+
+    std::vector<float> A_host(m * n);
+    std::vector<float> x_host(x_size);
+    std::vector<float> y_host(y_size);
+    for (auto& A_ij : A_host) A_ij = distribution(generator);
+    for (auto& x_i : x_host) x_i = distribution(generator);
+    for (auto& y_i : y_host) y_i = distribution(generator);
+    std::vector<float> y_valid = y_host;
+    host_blas::gemv(trans, m, n, alpha, A_host.data(), x_host.data(), beta,
+                    y_valid.data());
+
+    // Not allocated through the pool, since rounding up to its size classes
+    // could exceed the budget
+    float* x = sycl::malloc_device<float>(x_size, sycl_queue);
+    float* y = sycl::malloc_device<float>(y_size, sycl_queue);
+    std::vector<float*> panels(number_of_panels);
+    for (auto& panel : panels) {
+      panel = sycl::malloc_device<float>(m * panel_columns, sycl_queue);
+    }
+    staging::ring_t ring{sycl_queue, sizeof(float) * m * panel_columns};
+
+    sycl::event copy_x = sycl_queue.copy(x_host.data(), x, x_size);
+    sycl::event copy_y = sycl_queue.copy(y_host.data(), y, y_size);
+    auto launch = [&](const std::vector<sycl::event>& dependencies) {
+      return gemvStreamed(sycl_queue, ring, panels, panel_columns, trans, m,
+                          n, alpha, A_host.data(), x, beta, y, dependencies);
+    };
+
+    std::vector<float> y_result(y_size);
+    sycl_queue.copy(y, y_result.data(), y_size, launch({copy_x, copy_y}))
+        .wait();
+
+    // All entries are in [-1, 1], so each sum of k terms is bounded by
+    // |alpha| * k + |beta|
+    std::vector<float> y_scale(y_size, std::abs(alpha) * x_size +
+                                           std::abs(beta));
+    const double tolerance =
+        2.0 * (x_size + 2) * precision::traits<float>::epsilon;
+    if (!precision::verify(y_valid, y_result, y_scale, tolerance)) {
+      is_valid = false;
+    } else {
+      auto times = timing::timeTrials(sycl_queue, number_of_trials,
+                                      [&]() { return launch({}); });
+      auto stream_stats = timing::computeStats(times, benchmark.stats_options);
+      const double bytes =
+          sizeof(float) * double(m * n + x_size + 2 * y_size);
+      const double bandwidth =
+          (bytes / stream_stats.kernel().mean) * 1.0e-6;
+      std::cout << std::setw(12) << std::fixed << std::setprecision(2)
+                << ratio << std::setw(12) << n << std::setw(10)
+                << panel_columns << std::setw(15) << std::scientific
+                << std::setprecision(6) << stream_stats.kernel().mean
+                << std::setw(12) << std::fixed << std::setprecision(2)
+                << bandwidth << "\n";
+      timing::appendRecords(benchmark.records,
+                            "streamed_" + std::to_string(n), stream_stats,
+                            {{"bandwidth_gbps", bandwidth},
+                             {"budget_ratio", ratio}});
+    }
+
+    sycl_queue.wait();
+    for (auto& panel : panels) sycl::free(panel, sycl_queue);
+    sycl::free(x, sycl_queue);
+    sycl::free(y, sycl_queue);
+    if (!is_valid) break;
+  }
+  std::cout << "\n";
+  return is_valid;
 }
 
 }  // namespace
@@ -47,13 +553,10 @@ int main(int argc, char* argv[]) {
   auto arguments = readArguments(argc, argv);
   printArguments(arguments);
 
-  const size_t M = arguments.M;
-  const size_t N = arguments.N;
-  const size_t number_of_trials = arguments.trials;
-
-  std::vector<float> x_host(N);
-  std::vector<float> y_host(N);
-  std::vector<float> A_host(M * N);
+  size_t M = arguments.M;
+  size_t N = arguments.N;
+  bool is_trans = arguments.trans;
+  const size_t batch_size = arguments.batch_size;
 
   std::random_device seed{};
   std::mt19937_64 generator{seed()};
@@ -62,57 +565,180 @@ int main(int argc, char* argv[]) {
   const float alpha = distribution(generator);
   const float beta = distribution(generator);
 
-  for (auto& x_i : x_host) x_i = distribution(generator);
-  for (auto& y_i : y_host) y_i = distribution(generator);
-  for (auto& A_ij : A_host) A_ij = distribution(generator);
+  // A, and x and y if present, are read from the input file, and generated
+  // otherwise. Entries read from the file are used in place, without being
+  // copied, until they are uploaded to the device.
+  std::unique_ptr<matrix_io::mapped_file_t> input_file;
+  matrix_io::array_view_t<float> A_host;
+  matrix_io::array_view_t<float> x_host;
+  matrix_io::array_view_t<float> y_host;
+  if (!arguments.input.empty()) {
+    if (1 < batch_size) {
+      std::cerr << "Input files are not supported in batch mode\n";
+      return EXIT_FAILURE;
+    }
+    try {
+      input_file = std::make_unique<matrix_io::mapped_file_t>(arguments.input);
+      auto A_array = input_file->array<float>(0);
+      const auto& header = A_array.header;
+      const bool is_row_major = matrix_io::layout_t::row_major == header.layout;
+      if (header.ld != (is_row_major ? header.columns : header.rows)) {
+        std::cerr << "The leading dimension of A must equal its "
+                  << (is_row_major ? "columns" : "rows") << "\n";
+        return EXIT_FAILURE;
+      }
+      // A row-major matrix is stored as the transpose of a column-major one
+      M = is_row_major ? header.columns : header.rows;
+      N = is_row_major ? header.rows : header.columns;
+      if (is_row_major) is_trans = !is_trans;
+      A_host = A_array.entries;
+      if (1 < input_file->numberOfArrays()) {
+        x_host = input_file->array<float>(1).entries;
+      }
+      if (2 < input_file->numberOfArrays()) {
+        y_host = input_file->array<float>(2).entries;
+      }
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << "\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << "Input: " << M << " x " << N << "\n\n";
+  }
+
+  const transpose trans = is_trans ? transpose::trans : transpose::nontrans;
+  const size_t x_size = is_trans ? M : N;
+  const size_t y_size = is_trans ? N : M;
+
+  std::vector<float> A_generated;
+  std::vector<float> x_generated;
+  std::vector<float> y_generated;
+  auto generate = [&](std::vector<float>& entries, size_t size) {
+    entries.resize(size);
+    for (auto& entry : entries) entry = distribution(generator);
+    return matrix_io::array_view_t<float>{entries};
+  };
+  if (A_host.empty()) A_host = generate(A_generated, M * N * batch_size);
+  if (x_host.empty()) x_host = generate(x_generated, x_size * batch_size);
+  if (y_host.empty()) y_host = generate(y_generated, y_size * batch_size);
+  if (x_host.size() != x_size * batch_size ||
+      y_host.size() != y_size * batch_size) {
+    std::cerr << "The sizes of x and y do not match A\n";
+    return EXIT_FAILURE;
+  }
+
+  if (!arguments.output.empty()) {
+    if (1 < batch_size) {
+      std::cerr << "Output files are not supported in batch mode\n";
+      return EXIT_FAILURE;
+    }
+    matrix_io::write<float>(
+        arguments.output,
+        {matrix_io::makeArray<float>(M, N, M, A_host.data()),
+         matrix_io::makeArray<float>(x_size, 1, x_size, x_host.data()),
+         matrix_io::makeArray<float>(y_size, 1, y_size, y_host.data())});
+  }
+
+  std::vector<float> y_valid(y_host.begin(), y_host.end());
+  host_blas::gemv_batch(trans, M, N, alpha, A_host.data(), M * N,
+                        x_host.data(), x_size, beta, y_valid.data(), y_size,
+                        batch_size);
 
-  std::vector<float> y_valid = y_host;
-  gemv(M, N, alpha, A_host.data(), x_host.data(), beta, y_valid.data());
+  // A bound on the size of the terms summed to give each entry of y_valid:
+  // |alpha| * |A||x| + |beta| * |y|
+  std::vector<float> y_scale(y_host.size());
+  {
+    std::vector<float> A_abs(A_host.size());
+    std::vector<float> x_abs(x_host.size());
+    for (size_t i = 0; i < A_abs.size(); ++i) A_abs[i] = std::abs(A_host[i]);
+    for (size_t i = 0; i < x_abs.size(); ++i) x_abs[i] = std::abs(x_host[i]);
+    for (size_t i = 0; i < y_scale.size(); ++i) {
+      y_scale[i] = std::abs(y_host[i]);
+    }
+    host_blas::gemv_batch(trans, M, N, std::abs(alpha), A_abs.data(), M * N,
+                          x_abs.data(), x_size, std::abs(beta),
+                          y_scale.data(), y_size, batch_size);
+  }
 
   sycl::device sycl_device{sycl::default_selector()};
   sycl::context sycl_context{sycl_device};
-  sycl::queue sycl_queue{sycl_context, sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
 
-  float* x = sycl::malloc_device<float>(N, sycl_device, sycl_context);
-  float* y = sycl::malloc_device<float>(M, sycl_device, sycl_context);
-  float* A = sycl::malloc_device<float>(M * N, sycl_device, sycl_context);
+  // Allocate device memory through a pool, so kernels run with the same sizes
+  // reuse blocks instead of calling malloc_device and free each time
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+  benchmark_t benchmark{arguments.trials,
+                        {arguments.warmup, arguments.outlier_threshold},
+                        arguments.window,
+                        pool};
 
-  sycl::event copy_x = sycl_queue.copy(x_host.data(), x, N);
-  sycl::event copy_y = sycl_queue.copy(y_host.data(), y, M);
-  sycl::event copy_A = sycl_queue.copy(A_host.data(), A, M * N);
+  bool is_valid = true;
+  if (0.0 < arguments.memory_budget) {
+    // Stream matrices with M rows, from smaller to larger than the budget
+    is_valid &= runStreamingBenchmark(
+        sycl_queue, trans, M, arguments.memory_budget * (1 << 20), benchmark,
+        alpha, beta, generator);
+  } else if (1 < batch_size) {
+    float* x = pool.allocate<float>(x_host.size());
+    float* y = pool.allocate<float>(y_host.size());
+    float* A = pool.allocate<float>(A_host.size());
 
-  sycl::event gemv_kernel =
-      gemv(sycl_queue, M, N, alpha, A, x, beta, y, {copy_x, copy_y, copy_A});
+    sycl_queue.copy(x_host.data(), x, x_host.size());
+    sycl_queue.copy(A_host.data(), A, A_host.size());
+    sycl_queue.wait();
 
-  sycl_queue.copy(y, y_host.data(), M, {gemv_kernel}).wait();
+    // Compare one launch per matrix against the batched kernels
+    is_valid &= runBatchBenchmark<float, batch_mode::loop>(
+        sycl_queue, trans, M, N, batch_size, benchmark, alpha, A, x,
+        beta, y, y_host, y_valid, y_scale);
+    is_valid &= runBatchBenchmark<float, batch_mode::strided>(
+        sycl_queue, trans, M, N, batch_size, benchmark, alpha, A, x,
+        beta, y, y_host, y_valid, y_scale);
+    is_valid &= runBatchBenchmark<float, batch_mode::pointer_array>(
+        sycl_queue, trans, M, N, batch_size, benchmark, alpha, A, x,
+        beta, y, y_host, y_valid, y_scale);
 
-  // Verify correctness
-  for (int64_t i = 0; i < M; ++i) {
-    if (std::abs(y_host[i] - y_valid[i]) > 1.0e-4f) {
-      std::cout << "Verification failed!\n";
-      std::cout << "expected: " << y_valid[i] << "\n";
-      std::cout << "actual: " << y_host[i] << "\n";
-      return EXIT_FAILURE;
+    pool.deallocate(x);
+    pool.deallocate(y);
+    pool.deallocate(A);
+  } else {
+    if (arguments.run_naive) {
+      is_valid &= runPrecisions<false>(sycl_queue, trans, M, N, benchmark,
+                                       alpha, beta, A_host, x_host, y_host,
+                                       y_valid, y_scale);
+    }
+    if (arguments.run_tiled) {
+      is_valid &= runPrecisions<true>(sycl_queue, trans, M, N, benchmark,
+                                      alpha, beta, A_host, x_host, y_host,
+                                      y_valid, y_scale);
+    }
+    if (arguments.run_sub_group) {
+      // One version per sub-group size the device supports
+      device_blas::forEachSubGroupSize(sycl_device, [&](auto size) {
+        is_valid &= runPrecisions<true, decltype(size)::value>(
+            sycl_queue, trans, M, N, benchmark, alpha, beta, A_host, x_host,
+            y_host, y_valid, y_scale);
+      });
     }
   }
 
-  // Now run and time the kernel
-  std::vector<double> times(number_of_trials);
-  for (auto& runtime : times) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    gemv(sycl_queue, M, N, alpha, A, x, beta, y).wait();
-    auto finish_time = std::chrono::high_resolution_clock::now();
-    runtime =
-        std::chrono::duration<double, std::milli>(finish_time - start_time)
-            .count();
+  if (1 == batch_size && 0 < arguments.chunk_columns) {
+    is_valid &= runTransferBenchmark<false>(
+        sycl_queue, trans, M, N, arguments.chunk_columns, benchmark, alpha,
+        beta, A_host, x_host, y_host, y_valid);
+    is_valid &= runTransferBenchmark<true>(
+        sycl_queue, trans, M, N, arguments.chunk_columns, benchmark, alpha,
+        beta, A_host, x_host, y_host, y_valid);
   }
 
-  auto kernel_stats = stats::computeStats(times, "ms");
-  std::cout << "Kernel Times\n";
-  stats::printStats(kernel_stats);
+  memory_pool::printStats(pool.stats());
+
+  if (!arguments.stats_file.empty()) {
+    is_valid &= stats::writeRecords(arguments.stats_file, benchmark.records);
+  }
 
-  sycl::free(x, sycl_context);
-  sycl::free(y, sycl_context);
-  sycl::free(A, sycl_context);
-  return EXIT_SUCCESS;
+  return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,211 @@
+#include <CL/sycl.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "device_blas.hpp"
+#include "gemm.hpp"
+#include "host_blas.hpp"
+#include "memory_pool.hpp"
+#include "precision.hpp"
+#include "stats.hpp"
+#include "timing.hpp"
+
+namespace {
+
+// Parameters of the tiled gemm kernel; block_m, block_n and tile_k set the
+// size of the blocks cached in SLM, and reg_m x reg_n the number of entries
+// of C computed by each work-item.
+struct gemm_config_t {
+  int block_m;
+  int block_n;
+  int tile_k;
+  int reg_m;
+  int reg_n;
+};
+
+// Settings shared by all benchmarks, and the statistics they record
+struct benchmark_t {
+  size_t number_of_trials;
+  stats::options_t stats_options;
+  std::vector<stats::record_t<double>> records{};
+};
+
+// Verify a gemm kernel against the host result C_valid, then time it.
+// Setting config.block_m to zero selects the naive kernel.
+// Returns false if verification fails.
+template <typename Kernel>
+bool runBenchmark(sycl::queue& sycl_queue, const gemm_config_t& config,
+                  Kernel gemm_kernel, int64_t m, int64_t n, int64_t k,
+                  benchmark_t& benchmark, float* C,
+                  const std::vector<float>& C_host,
+                  const std::vector<float>& C_valid,
+                  const std::vector<float>& C_scale) {
+  std::string name = "naive";
+  if (0 == config.block_m) {
+    std::cout << "Naive Kernel\n";
+  } else {
+    name = "tiled_" + std::to_string(config.block_m) + "x" +
+           std::to_string(config.block_n) + "x" +
+           std::to_string(config.tile_k) + "_" +
+           std::to_string(config.reg_m) + "x" + std::to_string(config.reg_n);
+    std::cout << "Tiled Kernel, Block: " << config.block_m << "x"
+              << config.block_n << "x" << config.tile_k
+              << ", Registers: " << config.reg_m << "x" << config.reg_n
+              << "\n";
+
+    // Skip configurations the device cannot run
+    const auto device = sycl_queue.get_device();
+    const size_t local_size =
+        (config.block_m / config.reg_m) * (config.block_n / config.reg_n);
+    const size_t local_memory = sizeof(float) * config.tile_k *
+                                (config.block_m + config.block_n);
+    if (local_size >
+            device.get_info<sycl::info::device::max_work_group_size>() ||
+        local_memory > device.get_info<sycl::info::device::local_mem_size>()) {
+      std::cout << "Not supported by device.\n\n";
+      return true;
+    }
+  }
+
+  std::vector<float> C_result(C_host.size());
+  sycl::event copy_C = sycl_queue.copy(C_host.data(), C, C_host.size());
+  gemm_kernel({copy_C}).wait();
+  sycl_queue.copy(C, C_result.data(), C_result.size()).wait();
+
+  const double tolerance = 2.0 * (k + 2) * precision::traits<float>::epsilon;
+  if (!precision::verify(C_valid, C_result, C_scale, tolerance)) return false;
+
+  auto times = timing::timeTrials(sycl_queue, benchmark.number_of_trials,
+                                  [&]() { return gemm_kernel({}); });
+
+  const double flops = 2.0 * double(m) * double(n) * double(k);
+
+  auto kernel_stats = timing::computeStats(times, benchmark.stats_options);
+  const double gflops = (flops / kernel_stats.kernel().mean) * 1.0e-6;
+  timing::printStats(kernel_stats);
+  std::cout << "Performance: " << std::fixed << gflops << " GFLOP/s\n\n";
+  timing::appendRecords(benchmark.records, name, kernel_stats,
+                        {{"gflops", gflops}});
+  return true;
+}
+
+template <int block_m, int block_n, int tile_k, int reg_m, int reg_n>
+bool runTiled(sycl::queue& sycl_queue, int64_t m, int64_t n, int64_t k,
+              benchmark_t& benchmark, float alpha, const float* A,
+              const float* B, float beta, float* C,
+              const std::vector<float>& C_host,
+              const std::vector<float>& C_valid,
+              const std::vector<float>& C_scale) {
+  const gemm_config_t config{block_m, block_n, tile_k, reg_m, reg_n};
+  auto gemm_kernel = [&](const std::vector<sycl::event>& dependencies) {
+    return device_blas::gemm<float, block_m, block_n, tile_k, reg_m, reg_n>(
+        sycl_queue, m, n, k, alpha, A, m, B, k, beta, C, m, dependencies);
+  };
+  return runBenchmark(sycl_queue, config, gemm_kernel, m, n, k, benchmark,
+                      C, C_host, C_valid, C_scale);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  auto arguments = readArguments(argc, argv);
+  printArguments(arguments);
+
+  const size_t M = arguments.M;
+  const size_t N = arguments.N;
+  const size_t K = arguments.K;
+
+  std::vector<float> A_host(M * K);
+  std::vector<float> B_host(K * N);
+  std::vector<float> C_host(M * N);
+
+  std::random_device seed{};
+  std::mt19937_64 generator{seed()};
+  std::uniform_real_distribution<float> distribution(-1.0, 1.0);
+
+  const float alpha = distribution(generator);
+  const float beta = distribution(generator);
+
+  for (auto& A_ij : A_host) A_ij = distribution(generator);
+  for (auto& B_ij : B_host) B_ij = distribution(generator);
+  for (auto& C_ij : C_host) C_ij = distribution(generator);
+
+  // Host result, and a bound on the size of the terms summed to give each
+  // entry: |alpha| * |A||B| + |beta| * |C|.
+  std::vector<float> C_valid = C_host;
+  host_blas::gemm(M, N, K, alpha, A_host.data(), M, B_host.data(), K, beta,
+                  C_valid.data(), M);
+
+  std::vector<float> A_abs(A_host.size());
+  std::vector<float> B_abs(B_host.size());
+  std::vector<float> C_scale(C_host.size());
+  for (size_t i = 0; i < A_abs.size(); ++i) A_abs[i] = std::abs(A_host[i]);
+  for (size_t i = 0; i < B_abs.size(); ++i) B_abs[i] = std::abs(B_host[i]);
+  for (size_t i = 0; i < C_scale.size(); ++i) C_scale[i] = std::abs(C_host[i]);
+  host_blas::gemm(M, N, K, std::abs(alpha), A_abs.data(), M, B_abs.data(), K,
+                  std::abs(beta), C_scale.data(), M);
+
+  sycl::device sycl_device{sycl::default_selector()};
+  sycl::context sycl_context{sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
+
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+  benchmark_t benchmark{arguments.trials,
+                        {arguments.warmup, arguments.outlier_threshold}};
+
+  float* A = pool.allocate<float>(A_host.size());
+  float* B = pool.allocate<float>(B_host.size());
+  float* C = pool.allocate<float>(C_host.size());
+
+  sycl_queue.copy(A_host.data(), A, A_host.size());
+  sycl_queue.copy(B_host.data(), B, B_host.size());
+  sycl_queue.wait();
+
+  auto naive_kernel = [&](const std::vector<sycl::event>& dependencies) {
+    return device_blas::gemmNaive(sycl_queue, M, N, K, alpha, A, M, B, K, beta,
+                                  C, M, dependencies);
+  };
+  bool is_valid = runBenchmark(sycl_queue, gemm_config_t{}, naive_kernel, M, N,
+                               K, benchmark, C, C_host, C_valid, C_scale);
+
+  // Sweep block and register tile sizes; all use 256 work-items per group.
+  // The first matches examples/07_local_memory.cpp.
+  is_valid &= runTiled<16, 16, 8, 1, 1>(sycl_queue, M, N, K, benchmark, alpha,
+                                        A, B, beta, C, C_host, C_valid,
+                                        C_scale);
+  is_valid &= runTiled<32, 32, 8, 2, 2>(sycl_queue, M, N, K, benchmark, alpha,
+                                        A, B, beta, C, C_host, C_valid,
+                                        C_scale);
+  is_valid &= runTiled<32, 32, 16, 2, 2>(sycl_queue, M, N, K, benchmark, alpha,
+                                         A, B, beta, C, C_host, C_valid,
+                                         C_scale);
+  is_valid &= runTiled<64, 64, 8, 4, 4>(sycl_queue, M, N, K, benchmark, alpha,
+                                        A, B, beta, C, C_host, C_valid,
+                                        C_scale);
+  is_valid &= runTiled<64, 64, 16, 4, 4>(sycl_queue, M, N, K, benchmark, alpha,
+                                         A, B, beta, C, C_host, C_valid,
+                                         C_scale);
+  is_valid &= runTiled<128, 64, 8, 8, 4>(sycl_queue, M, N, K, benchmark, alpha,
+                                         A, B, beta, C, C_host, C_valid,
+                                         C_scale);
+  is_valid &= runTiled<128, 128, 8, 8, 8>(sycl_queue, M, N, K, benchmark, alpha,
+                                          A, B, beta, C, C_host, C_valid,
+                                          C_scale);
+
+  pool.deallocate(A);
+  pool.deallocate(B);
+  pool.deallocate(C);
+  memory_pool::printStats(pool.stats());
+
+  if (!arguments.stats_file.empty()) {
+    is_valid &= stats::writeRecords(arguments.stats_file, benchmark.records);
+  }
+
+  return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,620 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "device_blas.hpp"
+#include "memory_pool.hpp"
+#include "precision.hpp"
+#include "selector.hpp"
+#include "stats.hpp"
+#include "timing.hpp"
+
+namespace {
+
+using host_blas::transpose;
+
+// Device memory allocated from a pool, which is returned to it when the
+// buffers are destroyed, including when a kernel using them throws
+class buffers_t {
+ public:
+  explicit buffers_t(memory_pool::device_pool_t& pool) : pool_{pool} {}
+
+  buffers_t(const buffers_t&) = delete;
+  buffers_t& operator=(const buffers_t&) = delete;
+
+  ~buffers_t() {
+    for (void* ptr : ptrs_) pool_.deallocate(ptr);
+  }
+
+  // n entries, each set to value
+  template <typename T>
+  T* allocate(sycl::queue& sycl_queue, int64_t n, T value) {
+    T* x = pool_.allocate<T>(n);
+    ptrs_.push_back(x);
+    sycl_queue.fill(x, value, n).wait();
+    return x;
+  }
+
+ private:
+  memory_pool::device_pool_t& pool_;
+  std::vector<void*> ptrs_;
+};
+
+// One size of a kernel's problem, ready to run. launch() submits the kernel
+// on the data allocated when the problem was set up.
+struct problem_t {
+  std::string size;
+  double bytes;  // bytes that must be moved to or from global memory
+  double flops;
+  std::function<std::vector<sycl::event>()> launch;
+};
+
+// A registered kernel. setup(queue, buffers, working_set) allocates from
+// buffers, and initializes, a problem that uses about working_set bytes of
+// device memory.
+struct kernel_t {
+  std::string name;
+  std::function<problem_t(sycl::queue&, buffers_t&, double)> setup;
+};
+
+// Results of one kernel at one size
+struct result_t {
+  std::string kernel;
+  std::string size;
+  double bytes;
+  double flops;
+  timing::timing_stats_t stats;
+
+  double time() const { return stats.kernel().mean; }  // ms
+  double intensity() const { return flops / bytes; }
+  double bandwidth() const { return 1.0e-6 * bytes / time(); }
+  double gflops() const { return 1.0e-6 * flops / time(); }
+};
+
+// Runs dotTwoStage<true> number_of_runs times on random entries, and checks
+// that every result is bitwise identical to the first and within the
+// rounding error bound of the host result. An entry is combined with at
+// most depth others, in sequence or up a tree, on its way to the result.
+// Returns false if verification fails.
+bool verifyReproducibleDot(sycl::queue& sycl_queue,
+                           memory_pool::device_pool_t& pool, int64_t n,
+                           size_t number_of_runs) {
+  std::vector<float> x_host(n);
+  std::vector<float> y_host(n);
+  std::mt19937 generator;
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  for (auto& x_i : x_host) x_i = distribution(generator);
+  for (auto& y_i : y_host) y_i = distribution(generator);
+
+  double dot_valid{};
+  double dot_scale{};
+  for (int64_t i = 0; i < n; ++i) {
+    dot_valid += double(x_host[i]) * double(y_host[i]);
+    dot_scale += std::abs(double(x_host[i]) * double(y_host[i]));
+  }
+
+  int tree_depth{};
+  while ((1 << tree_depth) < device_blas::reduce_block_size) ++tree_depth;
+  const int64_t number_of_partials = device_blas::numberOfPartials(n);
+  const int64_t depth =
+      device_blas::reduce_items_per_work_item + tree_depth +
+      (number_of_partials + device_blas::reduce_block_size - 1) /
+          device_blas::reduce_block_size +
+      tree_depth;
+  const double tolerance = (depth + 1) * precision::traits<float>::epsilon;
+
+  buffers_t buffers{pool};
+  float* x = buffers.allocate(sycl_queue, n, 0.0f);
+  float* y = buffers.allocate(sycl_queue, n, 0.0f);
+  float* partials = buffers.allocate(sycl_queue, number_of_partials, 0.0f);
+  float* result = buffers.allocate(sycl_queue, 1, 0.0f);
+  sycl_queue.copy(x_host.data(), x, n);
+  sycl_queue.copy(y_host.data(), y, n);
+  sycl_queue.wait();
+
+  std::vector<float> results(number_of_runs);
+  for (auto& result_host : results) {
+    sycl::event::wait(device_blas::dotTwoStage<true>(sycl_queue, n, x, y,
+                                                     partials, result));
+    sycl_queue.copy(result, &result_host, 1).wait();
+  }
+
+  bool is_valid = precision::verify(std::vector<double>{dot_valid}, results,
+                                    std::vector<double>{dot_scale}, tolerance);
+  for (const auto& result_host : results) {
+    if (0 != std::memcmp(&result_host, &results[0], sizeof(float))) {
+      std::cout << "Reproducible dot differs between runs: " << results[0]
+                << " and " << result_host << "\n";
+      is_valid = false;
+      break;
+    }
+  }
+  return is_valid;
+}
+
+// Checks reduceStatistics, in one pass and as separate kernels, against the
+// host on the distinct integers -n/2 to n/2 in random order, with y drawn
+// from -1, 0 and 1. The maximum is copied to a second, later location, so
+// argmax must break the tie by the smaller index. The dot product, sum,
+// minimum and maximum are exact whatever the order of combination, since
+// every partial sum is an integer below 2^24; the squared norm is not, and
+// is bounded as a sequential sum of n terms. Returns false if verification
+// fails.
+bool verifyStatistics(sycl::queue& sycl_queue,
+                      memory_pool::device_pool_t& pool, int64_t n) {
+  namespace statistic = device_blas::statistic;
+  using device_blas::reduceStatistics;
+
+  std::vector<float> x_host(n);
+  std::vector<float> y_host(n);
+  std::mt19937 generator;
+  std::uniform_int_distribution<int> distribution(-1, 1);
+  for (int64_t i = 0; i < n; ++i) x_host[i] = float(i - n / 2);
+  std::shuffle(x_host.begin(), x_host.end(), generator);
+  for (auto& y_i : y_host) y_i = float(distribution(generator));
+
+  const int64_t argmax_valid = std::min<int64_t>(n / 3, n - 2);
+  const auto max_entry = std::max_element(x_host.begin(), x_host.end());
+  std::swap(*max_entry, x_host[argmax_valid]);
+  x_host[n - 1] = x_host[argmax_valid];
+
+  double dot_valid{};
+  double norm2_valid{};
+  double sum_valid{};
+  for (int64_t i = 0; i < n; ++i) {
+    dot_valid += double(x_host[i]) * double(y_host[i]);
+    norm2_valid += double(x_host[i]) * double(x_host[i]);
+    sum_valid += double(x_host[i]);
+  }
+  const float min_valid = *std::min_element(x_host.begin(), x_host.end());
+  const float max_valid = x_host[argmax_valid];
+  const double norm2_tolerance = n * precision::traits<float>::epsilon;
+
+  buffers_t buffers{pool};
+  float* x = buffers.allocate(sycl_queue, n, 0.0f);
+  float* y = buffers.allocate(sycl_queue, n, 0.0f);
+  auto* result =
+      buffers.allocate(sycl_queue, 1, device_blas::statistics_t<float>{});
+  sycl_queue.copy(x_host.data(), x, n);
+  sycl_queue.copy(y_host.data(), y, n);
+  sycl_queue.wait();
+
+  bool is_valid = true;
+  for (bool is_single_pass : {true, false}) {
+    if (is_single_pass) {
+      reduceStatistics<statistic::all>(sycl_queue, n, x, y, result).wait();
+    } else {
+      sycl::event::wait(
+          {reduceStatistics<statistic::dot>(sycl_queue, n, x, y, result),
+           reduceStatistics<statistic::norm2>(sycl_queue, n, x, y, result),
+           reduceStatistics<statistic::sum>(sycl_queue, n, x, y, result),
+           reduceStatistics<statistic::min>(sycl_queue, n, x, y, result),
+           reduceStatistics<statistic::max>(sycl_queue, n, x, y, result),
+           reduceStatistics<statistic::argmax>(sycl_queue, n, x, y,
+                                               result)});
+    }
+    device_blas::statistics_t<float> result_host;
+    sycl_queue.copy(result, &result_host, 1).wait();
+
+    const bool is_statistics_valid =
+        double(result_host.dot) == dot_valid &&
+        std::abs(double(result_host.norm2) - norm2_valid) <=
+            norm2_tolerance * norm2_valid &&
+        double(result_host.sum) == sum_valid &&
+        result_host.min == min_valid && result_host.max == max_valid &&
+        result_host.argmax.value == max_valid &&
+        result_host.argmax.index == argmax_valid;
+    if (!is_statistics_valid) {
+      std::cout << "Verification failed for "
+                << (is_single_pass ? "statistics" : "statistics_separate")
+                << "!\n";
+      std::cout << "expected: dot " << dot_valid << ", norm2 " << norm2_valid
+                << ", sum " << sum_valid << ", min " << min_valid << ", max "
+                << max_valid << " at " << argmax_valid << "\n";
+      std::cout << "actual: dot " << result_host.dot << ", norm2 "
+                << result_host.norm2 << ", sum " << result_host.sum
+                << ", min " << result_host.min << ", max " << result_host.max
+                << " at " << result_host.argmax.index << "\n";
+      is_valid = false;
+    }
+  }
+  return is_valid;
+}
+
+// The kernels from the exercises. The data is only initialized, not
+// verified; each kernel is verified by the exercise it comes from, and the
+// reductions, which have none, by the functions above.
+std::vector<kernel_t> registerKernels() {
+  std::vector<kernel_t> kernels;
+
+  // x is read, y is read and written
+  kernels.push_back(
+      {"axpy_batch",
+       [](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+         constexpr int64_t batch_size{10};
+         const int64_t n =
+             std::max<int64_t>(1, bytes / (2 * sizeof(float) * batch_size));
+         const int64_t total_size = n * batch_size;
+         float* x = buffers.allocate(sycl_queue, total_size, 1.0f);
+         float* y = buffers.allocate(sycl_queue, total_size, 1.0f);
+         return problem_t{
+             std::to_string(batch_size) + "x" + std::to_string(n),
+             3.0 * sizeof(float) * total_size, 2.0 * total_size,
+             [=, &sycl_queue]() {
+               return std::vector<sycl::event>{device_blas::axpy_batch(
+                   sycl_queue, total_size, 1.0f, x, n, y, n, batch_size)};
+             }};
+       }});
+
+  // The reduction from examples/08_reductions.cpp
+  kernels.push_back(
+      {"dot",
+       [](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+         const int64_t n = std::max<int64_t>(1, bytes / (2 * sizeof(float)));
+         float* x = buffers.allocate(sycl_queue, n, 1.0f);
+         float* y = buffers.allocate(sycl_queue, n, 1.0f);
+         float* result = buffers.allocate(sycl_queue, 1, 0.0f);
+         return problem_t{
+             std::to_string(n), 2.0 * sizeof(float) * n, 2.0 * n,
+             [=, &sycl_queue]() {
+               return std::vector<sycl::event>{
+                   device_blas::dot(sycl_queue, n, x, y, result)};
+             }};
+       }});
+
+  // The dot product as an explicit two-stage reduction, with the partials
+  // combined by reduce_over_group or, reproducibly, by a fixed tree. The
+  // first and second stages are also registered on their own.
+  for (std::string name : {"dot_two_stage", "dot_reproducible",
+                           "dot_two_stage_partials",
+                           "dot_two_stage_combine"}) {
+    kernels.push_back(
+        {name,
+         [=](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+           const int64_t n = std::max<int64_t>(1, bytes / (2 * sizeof(float)));
+           const int64_t number_of_partials = device_blas::numberOfPartials(n);
+           float* x = buffers.allocate(sycl_queue, n, 1.0f);
+           float* y = buffers.allocate(sycl_queue, n, 1.0f);
+           float* partials =
+               buffers.allocate(sycl_queue, number_of_partials, 0.0f);
+           float* result = buffers.allocate(sycl_queue, 1, 0.0f);
+
+           // The second stage reads only the partials
+           const bool is_combine = ("dot_two_stage_combine" == name);
+           const double moved = is_combine ? number_of_partials : 2.0 * n;
+           return problem_t{
+               std::to_string(n), sizeof(float) * moved, moved,
+               [=, &sycl_queue]() -> std::vector<sycl::event> {
+                 if ("dot_two_stage" == name) {
+                   return device_blas::dotTwoStage<false>(sycl_queue, n, x, y,
+                                                          partials, result);
+                 } else if ("dot_reproducible" == name) {
+                   return device_blas::dotTwoStage<true>(sycl_queue, n, x, y,
+                                                         partials, result);
+                 } else if (!is_combine) {
+                   return {device_blas::reduceToPartials<false>(
+                       sycl_queue, n,
+                       expr::vector(x, n) * expr::vector(y, n),
+                       sycl::plus<float>(), 0.0f, partials)};
+                 }
+                 return {device_blas::reducePartials(
+                     sycl_queue, number_of_partials, partials,
+                     sycl::plus<float>(), 0.0f, result)};
+               }};
+         }});
+  }
+
+  // Dot product, squared norm, sum, minimum, maximum and argmax. In one pass
+  // x and y are read once; as separate kernels, x is read by each of them.
+  for (bool is_single_pass : {true, false}) {
+    kernels.push_back(
+        {is_single_pass ? "statistics" : "statistics_separate",
+         [=](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+           namespace statistic = device_blas::statistic;
+           const int64_t n = std::max<int64_t>(1, bytes / (2 * sizeof(float)));
+           float* x = buffers.allocate(sycl_queue, n, 1.0f);
+           float* y = buffers.allocate(sycl_queue, n, 1.0f);
+           auto* result = buffers.allocate(
+               sycl_queue, 1, device_blas::statistics_t<float>{});
+           return problem_t{
+               std::to_string(n),
+               (is_single_pass ? 2.0 : 7.0) * sizeof(float) * n, 8.0 * n,
+               [=, &sycl_queue]() {
+                 using device_blas::reduceStatistics;
+                 if (is_single_pass) {
+                   return std::vector<sycl::event>{
+                       reduceStatistics<statistic::all>(sycl_queue, n, x, y,
+                                                        result)};
+                 }
+                 return std::vector<sycl::event>{
+                     reduceStatistics<statistic::dot>(sycl_queue, n, x, y,
+                                                      result),
+                     reduceStatistics<statistic::norm2>(sycl_queue, n, x, y,
+                                                        result),
+                     reduceStatistics<statistic::sum>(sycl_queue, n, x, y,
+                                                      result),
+                     reduceStatistics<statistic::min>(sycl_queue, n, x, y,
+                                                      result),
+                     reduceStatistics<statistic::max>(sycl_queue, n, x, y,
+                                                      result),
+                     reduceStatistics<statistic::argmax>(sycl_queue, n, x, y,
+                                                         result)};
+               }};
+         }});
+  }
+
+  // Unfused, axpy reads x and y and writes y, then dot reads y again. Fused,
+  // y is only read once.
+  for (bool is_fused : {false, true}) {
+    kernels.push_back(
+        {is_fused ? "axpy_dot_fused" : "axpy_dot",
+         [=](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+           const int64_t n = std::max<int64_t>(1, bytes / (2 * sizeof(float)));
+           float* x = buffers.allocate(sycl_queue, n, 1.0f);
+           float* y = buffers.allocate(sycl_queue, n, 1.0f);
+           float* normy = buffers.allocate(sycl_queue, 1, 0.0f);
+           return problem_t{
+               std::to_string(n), (is_fused ? 3.0 : 4.0) * sizeof(float) * n,
+               4.0 * n,
+               [=, &sycl_queue]() {
+                 if (!is_fused) {
+                   return device_blas::axpyDot(sycl_queue, n, 1.0f, x, y,
+                                               normy);
+                 }
+                 return std::vector<sycl::event>{device_blas::axpyDotFused(
+                     sycl_queue, n, 1.0f, x, y, normy)};
+               }};
+         }});
+  }
+
+  // Square n x n matrices. A is read once, x is read and y is read and
+  // written.
+  for (bool is_tiled : {false, true}) {
+    kernels.push_back(
+        {is_tiled ? "gemv_tiled" : "gemv",
+         [=](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+           const int64_t n =
+               std::max<int64_t>(1, std::sqrt(bytes / sizeof(float)));
+           float* a = buffers.allocate(sycl_queue, n * n, 1.0f);
+           float* x = buffers.allocate(sycl_queue, n, 1.0f);
+           float* y = buffers.allocate(sycl_queue, n, 0.0f);
+           return problem_t{
+               std::to_string(n) + "x" + std::to_string(n),
+               sizeof(float) * double(n * n + 3 * n), 2.0 * n * n,
+               [=, &sycl_queue]() {
+                 auto gemv_event =
+                     is_tiled ? device_blas::launchGemv<float, float, true>(
+                                    sycl_queue, transpose::nontrans, n, n,
+                                    1.0f, a, x, 0.0f, y)
+                              : device_blas::launchGemv<float, float, false>(
+                                    sycl_queue, transpose::nontrans, n, n,
+                                    1.0f, a, x, 0.0f, y);
+                 return std::vector<sycl::event>{gemv_event};
+               }};
+         }});
+  }
+
+  // A strided batch of gemv_batch_size square n x n matrices, each with its
+  // own x and y
+  constexpr int64_t gemv_batch_size{32};
+  kernels.push_back(
+      {"gemv_batch",
+       [=](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+         const int64_t n = std::max<int64_t>(
+             1, std::sqrt(bytes / (gemv_batch_size * sizeof(float))));
+         float* a = buffers.allocate(sycl_queue, gemv_batch_size * n * n, 1.0f);
+         float* x = buffers.allocate(sycl_queue, gemv_batch_size * n, 1.0f);
+         float* y = buffers.allocate(sycl_queue, gemv_batch_size * n, 0.0f);
+         return problem_t{
+             std::to_string(gemv_batch_size) + "x" + std::to_string(n) + "x" +
+                 std::to_string(n),
+             sizeof(float) * double(gemv_batch_size * (n * n + 3 * n)),
+             2.0 * gemv_batch_size * n * n,
+             [=, &sycl_queue]() {
+               return std::vector<sycl::event>{device_blas::gemv_batch(
+                   sycl_queue, transpose::nontrans, n, n, 1.0f, a, n * n, x,
+                   n, 0.0f, y, n, gemv_batch_size)};
+             }};
+       }});
+
+  // Square n x n matrices, counting only the compulsory traffic: A and B are
+  // read and C is written once. gemm_tiled uses the 16x16 blocks and tiles of
+  // 8 from examples/07_local_memory.cpp; gemm_blocked adds register blocking.
+  auto addGemm = [&](const std::string& name, auto gemm_kernel) {
+    kernels.push_back(
+        {name,
+         [=](sycl::queue& sycl_queue, buffers_t& buffers, double bytes) {
+           const int64_t n =
+               std::max<int64_t>(1, std::sqrt(bytes / (3 * sizeof(float))));
+           float* a = buffers.allocate(sycl_queue, n * n, 1.0f);
+           float* b = buffers.allocate(sycl_queue, n * n, 1.0f);
+           float* c = buffers.allocate(sycl_queue, n * n, 0.0f);
+           return problem_t{
+               std::to_string(n) + "x" + std::to_string(n) + "x" +
+                   std::to_string(n),
+               3.0 * sizeof(float) * n * n, 2.0 * n * n * n,
+               [=, &sycl_queue]() {
+                 return std::vector<sycl::event>{gemm_kernel(
+                     sycl_queue, n, n, n, 1.0f, a, n, b, n, 0.0f, c, n)};
+               }};
+         }});
+  };
+  addGemm("gemm_tiled", [](auto&&... args) {
+    return device_blas::gemm<float, 16, 16, 8, 1, 1>(args...);
+  });
+  addGemm("gemm_blocked", [](auto&&... args) {
+    return device_blas::gemm<float, 64, 64, 8, 4, 4>(args...);
+  });
+
+  return kernels;
+}
+
+// Prints each result against the roofline min(peak_gflops, intensity *
+// peak_bandwidth), i.e., the best performance possible at its arithmetic
+// intensity.
+void printRoofline(const std::vector<result_t>& results,
+                   double peak_bandwidth, double peak_gflops) {
+  std::cout << "Roofline: " << std::fixed << std::setprecision(2)
+            << peak_bandwidth << " GB/s, " << peak_gflops
+            << " GFLOP/s, ridge point " << peak_gflops / peak_bandwidth
+            << " FLOP/byte\n\n";
+
+  std::cout << std::left << std::setw(16) << "kernel" << std::setw(20)
+            << "size" << std::right << std::setw(12) << "bytes"
+            << std::setw(10) << "FLOP/B" << std::setw(12) << "time (ms)"
+            << std::setw(10) << "GB/s" << std::setw(10) << "GFLOP/s"
+            << std::setw(10) << "roofline" << std::setw(9) << "bound"
+            << "\n";
+  for (const auto& result : results) {
+    const double attainable =
+        std::min(peak_gflops, result.intensity() * peak_bandwidth);
+    const bool is_memory_bound =
+        result.intensity() * peak_bandwidth < peak_gflops;
+    std::cout << std::left << std::setw(16) << result.kernel << std::setw(20)
+              << result.size << std::right << std::scientific
+              << std::setprecision(3) << std::setw(12) << result.bytes
+              << std::fixed << std::setw(10) << result.intensity()
+              << std::scientific << std::setw(12) << result.time()
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << result.bandwidth() << std::setw(10) << result.gflops()
+              << std::setw(9) << 100.0 * result.gflops() / attainable << "%"
+              << std::setw(9) << (is_memory_bound ? "memory" : "compute")
+              << "\n";
+  }
+  std::cout << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  auto arguments = readArguments(argc, argv);
+  printArguments(arguments);
+
+  auto kernels = registerKernels();
+  for (const auto& name : arguments.kernels) {
+    if (std::none_of(kernels.begin(), kernels.end(),
+                     [&](const kernel_t& kernel) {
+                       return name == kernel.name;
+                     })) {
+      std::cerr << "Unknown kernel: " << name << "\nAvailable kernels:";
+      for (const auto& kernel : kernels) std::cerr << " " << kernel.name;
+      std::cerr << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The fastest device by its cached microbenchmark scores, or the default
+  sycl::device sycl_device =
+      arguments.fastest_device
+          ? sycl::device{selector::benchmark_selector_t()}
+          : sycl::device{sycl::default_selector()};
+  sycl::context sycl_context{sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
+
+  std::cout << "Device: " << sycl_device.get_info<sycl::info::device::name>()
+            << "\n\n";
+  const double max_alloc_size =
+      sycl_device.get_info<sycl::info::device::max_mem_alloc_size>();
+  const stats::options_t stats_options{arguments.warmup};
+
+  // Kernels registered later reuse the blocks of earlier ones of the same
+  // size
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+
+  // Kernels without an exercise of their own are verified before the sweep
+  auto isSelected = [&](const std::string& name) {
+    return arguments.kernels.empty() ||
+           std::find(arguments.kernels.begin(), arguments.kernels.end(),
+                     name) != arguments.kernels.end();
+  };
+  if (isSelected("dot_reproducible")) {
+    if (!verifyReproducibleDot(sycl_queue, pool, 1000003, 5)) {
+      return EXIT_FAILURE;
+    }
+    std::cout << "dot_reproducible verified\n\n";
+  }
+  if (isSelected("statistics") || isSelected("statistics_separate")) {
+    if (!verifyStatistics(sycl_queue, pool, 4097)) return EXIT_FAILURE;
+    std::cout << "statistics verified\n\n";
+  }
+
+  std::vector<result_t> results;
+  for (const auto& kernel : kernels) {
+    if (!isSelected(kernel.name)) continue;
+
+    // Sweep the working set size geometrically
+    for (double bytes = arguments.min_bytes;
+         bytes <= arguments.max_bytes * (1.0 + 1.0e-9);
+         bytes *= arguments.factor) {
+      if (bytes > max_alloc_size) break;
+
+      // Returned to the pool at the end of each size, even if it throws
+      buffers_t buffers{pool};
+      try {
+        problem_t problem = kernel.setup(sycl_queue, buffers, bytes);
+        std::cout << kernel.name << " " << problem.size << "\n";
+        auto timings = timing::timeTrials(sycl_queue, arguments.trials,
+                                          problem.launch);
+
+        results.push_back({kernel.name, problem.size, problem.bytes,
+                           problem.flops,
+                           timing::computeStats(timings, stats_options)});
+      } catch (const sycl::exception& e) {
+        // e.g., a work-group size or SLM use the device does not support
+        std::cout << kernel.name << " skipped: " << e.what() << "\n";
+        break;
+      }
+    }
+  }
+  std::cout << "\n";
+  memory_pool::printStats(pool.stats());
+
+  if (results.empty()) return EXIT_FAILURE;
+
+  // Without known peaks, use the best bandwidth and compute rate achieved
+  double peak_bandwidth = arguments.peak_bandwidth;
+  double peak_gflops = arguments.peak_gflops;
+  for (const auto& result : results) {
+    if (0.0 >= arguments.peak_bandwidth) {
+      peak_bandwidth = std::max(peak_bandwidth, result.bandwidth());
+    }
+    if (0.0 >= arguments.peak_gflops) {
+      peak_gflops = std::max(peak_gflops, result.gflops());
+    }
+  }
+  printRoofline(results, peak_bandwidth, peak_gflops);
+
+  if (!arguments.stats_file.empty()) {
+    std::vector<stats::record_t<double>> records;
+    for (const auto& result : results) {
+      const double attainable =
+          std::min(peak_gflops, result.intensity() * peak_bandwidth);
+      timing::appendRecords(records, result.kernel + "_" + result.size,
+                            result.stats,
+                            {{"bytes", result.bytes},
+                             {"flops", result.flops},
+                             {"intensity", result.intensity()},
+                             {"bandwidth_gbps", result.bandwidth()},
+                             {"gflops", result.gflops()},
+                             {"roofline_fraction",
+                              result.gflops() / attainable}});
+    }
+    if (!stats::writeRecords(arguments.stats_file, records)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
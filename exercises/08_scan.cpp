@@ -0,0 +1,166 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "device_scan.hpp"
+#include "memory_pool.hpp"
+#include "scan.hpp"
+#include "stats.hpp"
+#include "timing.hpp"
+
+namespace {
+
+// Runs f number_of_trials times on the host, returning the time of each (ms)
+template <typename F>
+std::vector<double> timeHost(size_t number_of_trials, F f) {
+  std::vector<double> times(number_of_trials);
+  for (auto& runtime : times) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    f();
+    auto finish_time = std::chrono::high_resolution_clock::now();
+    runtime = std::chrono::duration<double, std::milli>(finish_time -
+                                                        start_time)
+                  .count();
+  }
+  return times;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  auto arguments = readArguments(argc, argv);
+  printArguments(arguments);
+
+  const int64_t N = arguments.N;
+  const size_t number_of_trials = arguments.trials;
+  const int threshold = arguments.threshold;
+  auto is_selected = [=](int x_i) { return x_i < threshold; };
+
+  // Small entries, so the sums fit in an int and can be verified exactly
+  std::vector<int> x_host(N);
+  std::mt19937 generator;
+  std::uniform_int_distribution<int> distribution(0, 9);
+  for (auto& x_i : x_host) x_i = distribution(generator);
+
+  std::vector<int> exclusive_valid(N);
+  std::vector<int> inclusive_valid(N);
+  std::vector<int> compact_valid(N);
+  std::exclusive_scan(x_host.begin(), x_host.end(), exclusive_valid.begin(),
+                      0);
+  std::inclusive_scan(x_host.begin(), x_host.end(), inclusive_valid.begin());
+  const int64_t count_valid =
+      std::copy_if(x_host.begin(), x_host.end(), compact_valid.begin(),
+                   is_selected) -
+      compact_valid.begin();
+
+  sycl::device sycl_device{sycl::default_selector()};
+  sycl::context sycl_context{sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
+
+  const int64_t number_of_partials = device_scan::numberOfPartials(N);
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+  int* x = pool.allocate<int>(N);
+  int* y = pool.allocate<int>(N);
+  int* workspace = pool.allocate<int>(number_of_partials + 1);
+  int64_t* compact_workspace = pool.allocate<int64_t>(number_of_partials);
+  int64_t* count = pool.allocate<int64_t>(1);
+  sycl_queue.copy(x_host.data(), x, N).wait();
+
+  auto launch_exclusive = [&]() {
+    return std::vector<sycl::event>{
+        device_scan::exclusiveScan(sycl_queue, N, x, y, workspace)};
+  };
+  auto launch_inclusive = [&]() {
+    return std::vector<sycl::event>{
+        device_scan::inclusiveScan(sycl_queue, N, x, y, workspace)};
+  };
+  auto launch_compact = [&]() {
+    return std::vector<sycl::event>{device_scan::compactIf(
+        sycl_queue, N, x, y, count, is_selected, compact_workspace)};
+  };
+
+  // Verify each algorithm before timing it
+  std::vector<int> y_result(N);
+  bool is_valid = true;
+  sycl::event::wait(launch_exclusive());
+  sycl_queue.copy(y, y_result.data(), N).wait();
+  is_valid &= (exclusive_valid == y_result);
+  sycl::event::wait(launch_inclusive());
+  sycl_queue.copy(y, y_result.data(), N).wait();
+  is_valid &= (inclusive_valid == y_result);
+
+  int64_t count_result{};
+  sycl::event::wait(launch_compact());
+  sycl_queue.copy(count, &count_result, 1).wait();
+  sycl_queue.copy(y, y_result.data(), N).wait();
+  is_valid &= (count_valid == count_result) &&
+              std::equal(compact_valid.begin(),
+                         compact_valid.begin() + count_valid,
+                         y_result.begin());
+  if (!is_valid) {
+    std::cout << "Verification failed!\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "Selected " << count_result << " of " << N << " entries\n\n";
+
+  // A scan reads x and writes y; compaction reads x and writes the selected
+  // entries. The device reads x twice, which is not counted.
+  const double scan_bytes = 2.0 * sizeof(int) * N;
+  const double compact_bytes = sizeof(int) * double(N + count_valid);
+
+  auto host_scan_times = timeHost(number_of_trials, [&]() {
+    std::exclusive_scan(x_host.begin(), x_host.end(), y_result.begin(), 0);
+  });
+  auto host_scan_stats = stats::computeStats(host_scan_times, "ms");
+  std::cout << "Host Exclusive Scan Times\n";
+  stats::printStats(host_scan_stats);
+  timing::printBandwidth(scan_bytes, host_scan_stats.mean);
+
+  auto host_compact_times = timeHost(number_of_trials, [&]() {
+    std::copy_if(x_host.begin(), x_host.end(), y_result.begin(),
+                 is_selected);
+  });
+  auto host_compact_stats = stats::computeStats(host_compact_times, "ms");
+  std::cout << "Host Compaction Times\n";
+  stats::printStats(host_compact_stats);
+  timing::printBandwidth(compact_bytes, host_compact_stats.mean);
+
+  auto exclusive_times =
+      timing::timeTrials(sycl_queue, number_of_trials, launch_exclusive);
+  auto exclusive_stats = timing::computeStats(exclusive_times, {});
+  std::cout << "Device Exclusive Scan Times\n";
+  timing::printStats(exclusive_stats);
+  timing::printBandwidth(scan_bytes, exclusive_stats.kernel().mean);
+
+  auto inclusive_times =
+      timing::timeTrials(sycl_queue, number_of_trials, launch_inclusive);
+  auto inclusive_stats = timing::computeStats(inclusive_times, {});
+  std::cout << "Device Inclusive Scan Times\n";
+  timing::printStats(inclusive_stats);
+  timing::printBandwidth(scan_bytes, inclusive_stats.kernel().mean);
+
+  auto compact_times =
+      timing::timeTrials(sycl_queue, number_of_trials, launch_compact);
+  auto compact_stats = timing::computeStats(compact_times, {});
+  std::cout << "Device Compaction Times\n";
+  timing::printStats(compact_stats);
+  timing::printBandwidth(compact_bytes, compact_stats.kernel().mean);
+
+  std::cout << "Speedup over the host: scan "
+            << host_scan_stats.mean / exclusive_stats.kernel().mean
+            << ", compaction "
+            << host_compact_stats.mean / compact_stats.kernel().mean << "\n\n";
+
+  for (int* ptr : {x, y, workspace}) pool.deallocate(ptr);
+  for (int64_t* ptr : {compact_workspace, count}) pool.deallocate(ptr);
+  memory_pool::printStats(pool.stats());
+  return EXIT_SUCCESS;
+}
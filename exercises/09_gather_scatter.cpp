@@ -0,0 +1,186 @@
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "device_gather_scatter.hpp"
+#include "gather_scatter.hpp"
+#include "memory_pool.hpp"
+#include "timing.hpp"
+
+namespace {
+
+// Local nodes are stored element by element, as in the group_collectives
+// example: node (i, j) of element e is local node i + p * j + p^2 * e for p
+// nodes per side. Elements are numbered along x first on a structured 2D
+// mesh, and neighbouring elements share the nodes of their common edge.
+std::vector<int64_t> structuredMesh(int64_t elements, int64_t p) {
+  const int64_t global_nodes_x = elements * (p - 1) + 1;
+  std::vector<int64_t> global_ids(elements * elements * p * p);
+  for (int64_t ey = 0; ey < elements; ++ey) {
+    for (int64_t ex = 0; ex < elements; ++ex) {
+      const int64_t e = ex + elements * ey;
+      for (int64_t j = 0; j < p; ++j) {
+        for (int64_t i = 0; i < p; ++i) {
+          const int64_t x = ex * (p - 1) + i;
+          const int64_t y = ey * (p - 1) + j;
+          global_ids[i + p * j + p * p * e] = x + global_nodes_x * y;
+        }
+      }
+    }
+  }
+  return global_ids;
+}
+
+// Gather-scatter with atomics, for comparison: every local node is added to
+// its entry of a global vector, which is then scattered back. Returns the
+// events of all three kernels, so profiling covers all of them.
+template <typename T>
+std::vector<sycl::event> atomicGatherScatter(sycl::queue& sycl_queue,
+                                             int64_t local_nodes,
+                                             int64_t global_nodes,
+                                             const int64_t* global_ids, T* u,
+                                             T* global) {
+  sycl::event zero = sycl_queue.fill(global, T(0), global_nodes);
+  sycl::event gather = sycl_queue.parallel_for(
+      sycl::range<1>(local_nodes), zero, [=](sycl::id<1> l) {
+        sycl::atomic_ref<T, sycl::memory_order::relaxed,
+                         sycl::memory_scope::device,
+                         sycl::access::address_space::global_space>
+            sum(global[global_ids[l]]);
+        sum.fetch_add(u[l]);
+      });
+  sycl::event scatter = sycl_queue.parallel_for(
+      sycl::range<1>(local_nodes), gather,
+      [=](sycl::id<1> l) { u[l] = global[global_ids[l]]; });
+  return {zero, gather, scatter};
+}
+
+// Verifies and times both versions with values of type T
+template <typename T>
+int run(const arguments_t& arguments, sycl::queue& sycl_queue) {
+  const int64_t elements = arguments.elements;
+  const int64_t p = arguments.nodes;
+  const std::vector<int64_t> global_ids_host = structuredMesh(elements, p);
+  const int64_t local_nodes = global_ids_host.size();
+  const int64_t global_nodes =
+      (elements * (p - 1) + 1) * (elements * (p - 1) + 1);
+
+  // Small integers, so sums are exact whatever the order of summation
+  std::vector<T> u_host(local_nodes);
+  for (int64_t l = 0; l < local_nodes; ++l) u_host[l] = T(l % 7);
+
+  std::vector<T> global_host(global_nodes, T(0));
+  std::vector<T> u_valid(local_nodes);
+  for (int64_t l = 0; l < local_nodes; ++l) {
+    global_host[global_ids_host[l]] += u_host[l];
+  }
+  for (int64_t l = 0; l < local_nodes; ++l) {
+    u_valid[l] = global_host[global_ids_host[l]];
+  }
+
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+
+  // Setup: sort the local nodes into segments of copies of the same node
+  auto setup_start = std::chrono::high_resolution_clock::now();
+  device_gather_scatter::gather_scatter_t gather_scatter(sycl_queue, pool,
+                                                         global_ids_host);
+  auto setup_finish = std::chrono::high_resolution_clock::now();
+
+  std::cout << "Local nodes: " << local_nodes << "\n";
+  std::cout << "Global nodes: " << global_nodes << "\n";
+  std::cout << "Shared nodes: " << gather_scatter.numberOfSegments() << " ("
+            << gather_scatter.numberOfShared() << " copies)\n";
+  std::cout << "Setup Time: "
+            << std::chrono::duration<double, std::milli>(setup_finish -
+                                                         setup_start)
+                   .count()
+            << " ms\n\n";
+
+  T* u = pool.allocate<T>(local_nodes);
+  T* global = pool.allocate<T>(global_nodes);
+  int64_t* global_ids = pool.allocate<int64_t>(local_nodes);
+  sycl_queue.copy(global_ids_host.data(), global_ids, local_nodes).wait();
+
+  // Verify both versions
+  std::vector<T> u_result(local_nodes);
+  sycl_queue.copy(u_host.data(), u, local_nodes).wait();
+  gather_scatter.apply(u).wait();
+  sycl_queue.copy(u, u_result.data(), local_nodes).wait();
+  bool is_valid = (u_valid == u_result);
+
+  sycl_queue.copy(u_host.data(), u, local_nodes).wait();
+  sycl::event::wait(atomicGatherScatter(sycl_queue, local_nodes, global_nodes,
+                                        global_ids, u, global));
+  sycl_queue.copy(u, u_result.data(), local_nodes).wait();
+  is_valid &= (u_valid == u_result);
+  if (!is_valid) {
+    std::cout << "Verification failed!\n";
+    return EXIT_FAILURE;
+  }
+
+  // Repeated applies sum sums, so time them on zeros to keep values finite
+  sycl_queue.fill(u, T(0), local_nodes).wait();
+
+  // Each copy of a shared node is read and written once, and the sorted
+  // order and offsets are read once.
+  const double segmented_bytes =
+      double(gather_scatter.numberOfShared()) *
+          (2 * sizeof(T) + sizeof(int32_t)) +
+      double(gather_scatter.numberOfSegments() + 1) * sizeof(int32_t);
+  auto segmented_times = timing::timeTrials(
+      sycl_queue, arguments.trials, [&]() { return gather_scatter.apply(u); });
+  auto segmented_stats = timing::computeStats(segmented_times, {});
+  std::cout << "Segmented Gather-Scatter Times\n";
+  timing::printStats(segmented_stats);
+  timing::printBandwidth(segmented_bytes, segmented_stats.kernel().mean);
+
+  // Every local node is read and written once and its global id read twice,
+  // and every global node is zeroed, added to and read.
+  const double atomic_bytes =
+      double(local_nodes) * (2 * sizeof(T) + 2 * sizeof(int64_t)) +
+      double(global_nodes) * 3 * sizeof(T);
+  auto atomic_times =
+      timing::timeTrials(sycl_queue, arguments.trials, [&]() {
+        return atomicGatherScatter(sycl_queue, local_nodes, global_nodes,
+                                   global_ids, u, global);
+      });
+  auto atomic_stats = timing::computeStats(atomic_times, {});
+  std::cout << "Atomic Gather-Scatter Times\n";
+  timing::printStats(atomic_stats);
+  timing::printBandwidth(atomic_bytes, atomic_stats.kernel().mean);
+
+  std::cout << "Speedup over atomics: "
+            << atomic_stats.kernel().mean / segmented_stats.kernel().mean
+            << "\n\n";
+
+  pool.deallocate(u);
+  pool.deallocate(global);
+  pool.deallocate(global_ids);
+  memory_pool::printStats(pool.stats());
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  auto arguments = readArguments(argc, argv);
+  printArguments(arguments);
+
+  sycl::device sycl_device{sycl::default_selector()};
+  sycl::context sycl_context{sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
+
+  // The atomic version adds doubles with 64-bit atomics. The values summed
+  // are small integers, so float gives the same sums on other devices.
+  if (sycl_device.has(sycl::aspect::fp64) &&
+      sycl_device.has(sycl::aspect::atomic64)) {
+    return run<double>(arguments, sycl_queue);
+  }
+  std::cout << "Device lacks fp64 or 64-bit atomics, using float\n\n";
+  return run<float>(arguments, sycl_queue);
+}
@@ -0,0 +1,123 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include "device_elementwise.hpp"
+#include "memory_pool.hpp"
+#include "timing.hpp"
+#include "vector_width.hpp"
+
+namespace {
+
+// Calls f with each width as a std::integral_constant
+template <int... widths, typename F>
+void forEachWidth(F f) {
+  (f(std::integral_constant<int, widths>()), ...);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  using T = float;
+
+  auto arguments = readArguments(argc, argv);
+  printArguments(arguments);
+
+  const int64_t N = arguments.N;
+  const size_t number_of_trials = arguments.trials;
+  const T alpha = 2.0;
+  const T s = 1.0;
+
+  sycl::device sycl_device{sycl::default_selector()};
+  sycl::context sycl_context{sycl_device};
+  sycl::property_list properties;
+  if (arguments.profile) {
+    properties = {sycl::property::queue::enable_profiling()};
+  }
+  sycl::queue sycl_queue{sycl_context, sycl_device, properties};
+
+  memory_pool::device_pool_t pool{sycl_queue, !arguments.no_pool};
+  T* x = pool.allocate<T>(N);
+  T* y = pool.allocate<T>(N);
+  T* a = pool.allocate<T>(N);
+  sycl_queue.fill(x, T(1), N).wait();
+
+  std::vector<T> result(N);
+  // Whether the first n entries of v are value, and the rest are rest
+  auto isAll = [&](const T* v, int64_t n, T value, T rest) {
+    sycl_queue.copy(v, result.data(), N).wait();
+    auto equals = [](T expected) {
+      return [=](T v_i) { return expected == v_i; };
+    };
+    return std::all_of(result.begin(), result.begin() + n, equals(value)) &&
+           std::all_of(result.begin() + n, result.end(), equals(rest));
+  };
+
+  // Checks each kernel on the first n entries, and that it leaves the rest
+  // alone; x is all ones
+  auto verify = [&](auto width_constant, int64_t n) {
+    constexpr int width = decltype(width_constant)::value;
+    bool is_valid = true;
+    sycl_queue.fill(y, T(1), N);
+    sycl_queue.fill(a, T(0), N);
+    sycl_queue.wait();
+    device_elementwise::axpy<width>(sycl_queue, n, alpha, x, y).wait();
+    is_valid &= isAll(y, n, alpha + 1, 1);
+    device_elementwise::triad<width>(sycl_queue, n, s, x, x, a).wait();
+    is_valid &= isAll(a, n, 1 + s, 0);
+    device_elementwise::scale<width>(sycl_queue, n, alpha, x, y).wait();
+    is_valid &= isAll(y, n, alpha, 1);
+    return is_valid;
+  };
+
+  // Streams of 2 or 3 vectors of N entries
+  const double two_vectors = 2.0 * sizeof(T) * N;
+  const double three_vectors = 3.0 * sizeof(T) * N;
+  auto bandwidth = [&](timing::timings_t& timings, double bytes) {
+    return bytes / timing::computeStats(timings, {}).kernel().mean * 1.0e-6;
+  };
+
+  std::cout << "Effective Bandwidth (GB/s)\n";
+  std::cout << std::setw(6) << "width" << std::setw(12) << "axpy"
+            << std::setw(12) << "triad" << std::setw(12) << "scale" << "\n";
+
+  bool is_valid = true;
+  forEachWidth<1, 2, 4, 8, 16>([&](auto width_constant) {
+    constexpr int width = decltype(width_constant)::value;
+
+    // Verify each kernel before timing it, also on a small odd size so the
+    // remainder is covered whatever N is
+    is_valid &= verify(width_constant, N);
+    is_valid &= verify(width_constant, std::min<int64_t>(N, 1001));
+    if (!is_valid) return;
+
+    auto axpy_times = timing::timeTrials(sycl_queue, number_of_trials, [&]() {
+      return device_elementwise::axpy<width>(sycl_queue, N, alpha, x, y);
+    });
+    auto triad_times =
+        timing::timeTrials(sycl_queue, number_of_trials, [&]() {
+          return device_elementwise::triad<width>(sycl_queue, N, s, x, y, a);
+        });
+    auto scale_times =
+        timing::timeTrials(sycl_queue, number_of_trials, [&]() {
+          return device_elementwise::scale<width>(sycl_queue, N, alpha, x, y);
+        });
+
+    std::cout << std::setw(6) << width << std::fixed << std::setprecision(2)
+              << std::setw(12) << bandwidth(axpy_times, three_vectors)
+              << std::setw(12) << bandwidth(triad_times, three_vectors)
+              << std::setw(12) << bandwidth(scale_times, two_vectors) << "\n";
+  });
+
+  if (!is_valid) {
+    std::cout << "Verification failed!\n";
+    return EXIT_FAILURE;
+  }
+
+  for (T* ptr : {x, y, a}) pool.deallocate(ptr);
+  memory_pool::printStats(pool.stats());
+  return EXIT_SUCCESS;
+}
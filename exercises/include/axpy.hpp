@@ -4,34 +4,88 @@
 #include <getopt.h>
 
 #include <iostream>
+#include <string>
 
 namespace {
 
 struct arguments_t {
   size_t N = 2000;
   size_t batch_size = 10;
+  size_t trials = 100;
+  size_t chunk_size = 0;  // vectors per staged chunk, 0 to skip staging
+  std::string input;      // matrix file to read x and y from
+  std::string output;     // matrix file to write x and y to
+  std::string partition;  // devices, equally or numa; empty for one queue
+  size_t partitions = 2;  // sub-devices to create with equally
+  bool profile = false;
+  bool no_pool = false;
 };
 
 arguments_t readArguments(int argc, char* argv[]) {
   static struct option long_options[] = {
       {"vector-size", required_argument, 0, 'N'},
-      {"batch-size", required_argument, 0, 'B'}};
+      {"batch-size", required_argument, 0, 'B'},
+      {"trials", required_argument, 0, 'T'},
+      {"chunk-size", required_argument, 0, 'C'},
+      {"input", required_argument, 0, 'i'},
+      {"output", required_argument, 0, 'o'},
+      {"partition", required_argument, 0, 'p'},
+      {"partitions", required_argument, 0, 'n'},
+      {"profile", no_argument, 0, 'P'},
+      {"no-pool", no_argument, 0, 'D'},
+      {0, 0, 0, 0}};
 
   arguments_t arguments;
   while (1) {
     int option_index{};
-    int c = getopt_long(argc, argv, "N:B:", long_options, &option_index);
+    int c = getopt_long(argc, argv, "N:B:T:C:i:o:p:n:PD", long_options,
+                        &option_index);
     if (0 > c) break;
 
     switch (c) {
       case 'N':
         arguments.N = std::stoul(optarg);
+        if (1 > arguments.N) {
+          std::cerr << "Vector size must be at least 1\n";
+          exit(EXIT_FAILURE);
+        }
         break;
       case 'B':
         arguments.batch_size = std::stoul(optarg);
+        if (1 > arguments.batch_size) {
+          std::cerr << "Batch size must be at least 1\n";
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'T':
+        arguments.trials = std::stoul(optarg);
+        break;
+      case 'C':
+        arguments.chunk_size = std::stoul(optarg);
+        break;
+      case 'i':
+        arguments.input = optarg;
+        break;
+      case 'o':
+        arguments.output = optarg;
+        break;
+      case 'p':
+        arguments.partition = optarg;
+        break;
+      case 'n':
+        arguments.partitions = std::stoul(optarg);
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'D':
+        arguments.no_pool = true;
         break;
       default:
-        std::cerr << "Usage: batch_axpy [-N vector-size] [-B batch-size]\n";
+        std::cerr << "Usage: batch_axpy [-N vector-size] [-B batch-size] "
+                     "[-T trials] [-C chunk-size] [-i input-file] "
+                     "[-o output-file] [-p devices|equally|numa] "
+                     "[-n partitions] [-P] [-D]\n";
         exit(EXIT_FAILURE);
     }
   }
@@ -41,6 +95,25 @@ arguments_t readArguments(int argc, char* argv[]) {
 void printArguments(const arguments_t& arguments) {
   std::cout << "N: " << arguments.N << "\n";
   std::cout << "Batch Size: " << arguments.batch_size << "\n";
+  std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  if (0 < arguments.chunk_size) {
+    std::cout << "Chunk Size: " << arguments.chunk_size << " vectors\n";
+  }
+  if (!arguments.input.empty()) {
+    std::cout << "Input File: " << arguments.input << "\n";
+  }
+  if (!arguments.output.empty()) {
+    std::cout << "Output File: " << arguments.output << "\n";
+  }
+  if (!arguments.partition.empty()) {
+    std::cout << "Partitioning: " << arguments.partition;
+    if ("equally" == arguments.partition) {
+      std::cout << " (" << arguments.partitions << " sub-devices)";
+    }
+    std::cout << "\n";
+  }
   std::cout << "\n";
 }
 
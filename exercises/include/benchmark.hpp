@@ -0,0 +1,140 @@
+#ifndef _BENCHMARK_HPP_
+#define _BENCHMARK_HPP_
+#include <getopt.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct arguments_t {
+  // Working set sizes, in bytes, swept geometrically from min to max
+  double min_bytes = 1 << 20;
+  double max_bytes = 1 << 28;
+  double factor = 4.0;
+  size_t trials = 20;
+  size_t warmup = 2;
+  std::vector<std::string> kernels;  // empty for all kernels
+  double peak_bandwidth = 0.0;       // GB/s, 0 to use the best achieved
+  double peak_gflops = 0.0;          // GFLOP/s, 0 to use the best achieved
+  std::string stats_file;
+  bool profile = false;
+  bool fastest_device = false;  // select the device by benchmark scores
+  bool no_pool = false;
+};
+
+arguments_t readArguments(int argc, char* argv[]) {
+  static struct option long_options[] = {
+      {"min-bytes", required_argument, 0, 'm'},
+      {"max-bytes", required_argument, 0, 'M'},
+      {"factor", required_argument, 0, 'f'},
+      {"trials", required_argument, 0, 'T'},
+      {"warmup", required_argument, 0, 'W'},
+      {"kernel", required_argument, 0, 'k'},
+      {"peak-bandwidth", required_argument, 0, 'b'},
+      {"peak-gflops", required_argument, 0, 'g'},
+      {"stats-file", required_argument, 0, 'S'},
+      {"profile", no_argument, 0, 'P'},
+      {"fastest-device", no_argument, 0, 'F'},
+      {"no-pool", no_argument, 0, 'D'},
+      {0, 0, 0, 0}};
+
+  arguments_t arguments;
+  while (1) {
+    int option_index{};
+    int c = getopt_long(argc, argv, "m:M:f:T:W:k:b:g:S:PFD", long_options,
+                        &option_index);
+    if (0 > c) break;
+
+    switch (c) {
+      case 'm':
+        arguments.min_bytes = std::stod(optarg);
+        break;
+      case 'M':
+        arguments.max_bytes = std::stod(optarg);
+        break;
+      case 'f':
+        arguments.factor = std::stod(optarg);
+        if (1.0 >= arguments.factor) {
+          std::cerr << "The sweep factor must be greater than 1\n";
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'T':
+        arguments.trials = std::stoul(optarg);
+        break;
+      case 'W':
+        arguments.warmup = std::stoul(optarg);
+        break;
+      case 'k': {
+        // A comma separated list of kernel names
+        std::stringstream kernels{optarg};
+        std::string kernel;
+        while (std::getline(kernels, kernel, ',')) {
+          if (!kernel.empty()) arguments.kernels.push_back(kernel);
+        }
+        break;
+      }
+      case 'b':
+        arguments.peak_bandwidth = std::stod(optarg);
+        break;
+      case 'g':
+        arguments.peak_gflops = std::stod(optarg);
+        break;
+      case 'S':
+        arguments.stats_file = optarg;
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'F':
+        arguments.fastest_device = true;
+        break;
+      case 'D':
+        arguments.no_pool = true;
+        break;
+      default:
+        std::cerr << "Usage: benchmark [-m or --min-bytes bytes] [-M or "
+                     "--max-bytes bytes] [-f or --factor factor] [-T or "
+                     "--trials ntrials] [-W or --warmup nwarmup] [-k or "
+                     "--kernel name[,name...]] [-b or --peak-bandwidth GB/s] "
+                     "[-g or --peak-gflops GFLOP/s] [-S or --stats-file "
+                     "file.csv|file.json] [-P or --profile] [-F or "
+                     "--fastest-device] [-D or --no-pool]\n";
+        exit(EXIT_FAILURE);
+    }
+  }
+  return arguments;
+}
+
+void printArguments(const arguments_t& arguments) {
+  std::cout << "Working Set: " << arguments.min_bytes << " to "
+            << arguments.max_bytes << " bytes, factor " << arguments.factor
+            << "\n";
+  std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Warm-up Trials: " << arguments.warmup << "\n";
+  std::cout << "Kernels:";
+  if (arguments.kernels.empty()) std::cout << " all";
+  for (const auto& kernel : arguments.kernels) std::cout << " " << kernel;
+  std::cout << "\n";
+  if (0.0 < arguments.peak_bandwidth) {
+    std::cout << "Peak Bandwidth: " << arguments.peak_bandwidth << " GB/s\n";
+  }
+  if (0.0 < arguments.peak_gflops) {
+    std::cout << "Peak Compute: " << arguments.peak_gflops << " GFLOP/s\n";
+  }
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  if (arguments.fastest_device) {
+    std::cout << "Device Selection: fastest by benchmark score\n";
+  }
+  if (!arguments.stats_file.empty()) {
+    std::cout << "Statistics File: " << arguments.stats_file << "\n";
+  }
+  std::cout << "\n";
+}
+
+}  // namespace
+#endif
@@ -0,0 +1,32 @@
+#ifndef _BUNDLE_HPP_
+#define _BUNDLE_HPP_
+
+#include <CL/sycl.hpp>
+#include <vector>
+
+// Kernels compiled to SPIR-V are JIT-compiled for the device the first time
+// they are launched, so the first launch of each kernel can take orders of
+// magnitude longer than the rest. Building a kernel bundle up front moves
+// that cost out of the first launch, and makes it explicit and measurable.
+namespace bundle {
+
+using executable_t = sycl::kernel_bundle<sycl::bundle_state::executable>;
+
+// Builds every kernel of the program for the queue's device. Getting the
+// bundle in executable state builds kernels available as SPIR-V, as
+// sycl::build would, and uses ahead-of-time compiled images as they are.
+inline executable_t build(const sycl::queue& sycl_queue) {
+  return sycl::get_kernel_bundle<sycl::bundle_state::executable>(
+      sycl_queue.get_context(), std::vector<sycl::device>{
+                                    sycl_queue.get_device()});
+}
+
+// Makes a command group use bundle, if there is one, instead of the kernels
+// the runtime would otherwise build on demand.
+inline void use(sycl::handler& cgh, const executable_t* bundle) {
+  if (nullptr != bundle) cgh.use_kernel_bundle(*bundle);
+}
+
+}  // namespace bundle
+
+#endif
@@ -0,0 +1,861 @@
+#ifndef _DEVICE_BLAS_HPP_
+#define _DEVICE_BLAS_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "bundle.hpp"
+#include "expression.hpp"
+#include "host_blas.hpp"
+
+// Reusable SYCL implementations of BLAS functions. All matrices are
+// column-major.
+namespace device_blas {
+
+// Aliasing oneAPI DPC++ specific extensions
+namespace dpcpp = sycl::ext::oneapi;
+
+using host_blas::transpose;
+
+// Given a group of vectors of the same length, compute
+// for (b=0; b < batch_size; ++b) {
+//   Y += alpha * X
+// }
+// where X is a vector located at offset stride_x * b in x
+// and Y is a vector located at offset stride_y * b in y
+//
+// N is the size of contiguous memory used to store the vectors.
+// Vectors are stored as T, while arithmetic is done in Tacc.
+template <typename T, typename Tacc>
+sycl::event axpy_batch(sycl::queue& queue, int64_t N, Tacc alpha, const T* x,
+                       int64_t stride_x, T* y, int64_t stride_y,
+                       int64_t batch_size,
+                       const std::vector<sycl::event>& dependencies = {}) {
+  if (1 > batch_size) {
+    throw std::logic_error("batch_size is less than 1");
+  }
+  if (N < batch_size * stride_x) {
+    throw std::logic_error("N is smaller than batch_size * stride_x");
+  }
+  if (N < batch_size * stride_y) {
+    throw std::logic_error("N is smaller than batch_size * stride_y");
+  }
+
+  // The last dimension is the "fastest".
+  sycl::range<2> kernel_range(batch_size, N / batch_size);
+  sycl::event kernel_event = queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::id<2> index) {
+        // Find the batch index, and the index within the current vector
+        int64_t batch_i = index[0];
+        int64_t i = index[1];
+
+        // Create pointers to the start of each vector for this axpy.
+        const T* batch_x = x + stride_x * batch_i;
+        T* batch_y = y + stride_y * batch_i;
+
+        // Calculate axpy for the current vectors.
+        batch_y[i] = static_cast<T>(alpha * static_cast<Tacc>(batch_x[i]) +
+                                    static_cast<Tacc>(batch_y[i]));
+      });
+
+  return kernel_event;
+}
+
+// Computes the dot product of x and y, adding it to *result
+template <typename T>
+sycl::event dot(sycl::queue& sycl_queue, int64_t n, const T* x, const T* y,
+                T* result, const std::vector<sycl::event>& dependencies = {}) {
+  sycl::range<1> kernel_range(n);
+
+  // Currently it is not possible to use the queue::parallel_for shortcuts
+  // when passing dependent events and reductions
+  return sycl_queue.submit([&](sycl::handler& cgh) {
+    cgh.depends_on(dependencies);
+    auto reduce_result = sycl::reduction(result, sycl::plus<>());
+    cgh.parallel_for(
+        kernel_range, reduce_result,
+        [=](sycl::id<1> i, auto& result_) { result_ += x[i] * y[i]; });
+  });
+}
+
+// Computes y += alpha * x and then *normy += y^T y with two kernels.
+// Returns the events of both kernels, so each can be profiled. If bundle is
+// given, the kernels are launched from it.
+template <typename T>
+std::vector<sycl::event> axpyDot(
+    sycl::queue& sycl_queue, int64_t N, T alpha, const T* x, T* y, T* normy,
+    const std::vector<sycl::event>& dependencies = {},
+    const bundle::executable_t* kernel_bundle = nullptr) {
+  sycl::range<1> kernel_range(N);
+
+  // First compute axpy
+  sycl::event axpy_event = sycl_queue.submit([&](sycl::handler& cgh) {
+    cgh.depends_on(dependencies);
+    bundle::use(cgh, kernel_bundle);
+    cgh.parallel_for(kernel_range,
+                     [=](sycl::id<1> i) { y[i] += alpha * x[i]; });
+  });
+
+  // Next compute dot y
+  sycl::event normy_event = sycl_queue.submit([&](sycl::handler& cgh) {
+    cgh.depends_on(axpy_event);
+    bundle::use(cgh, kernel_bundle);
+
+    auto reduce_normy = sycl::reduction(normy, sycl::plus<>());
+    cgh.parallel_for(kernel_range, reduce_normy,
+                     [=](sycl::id<1> it, auto& normy_) {
+                       size_t i = it;
+                       if (i < N) normy_ += y[i] * y[i];
+                     });
+  });
+
+  return {axpy_event, normy_event};
+}
+
+// Same as above, but with axpy and dot fused into one kernel, so y is only
+// read once.
+template <typename T>
+sycl::event axpyDotFused(sycl::queue& sycl_queue, int64_t N, T alpha,
+                         const T* x, T* y, T* normy,
+                         const std::vector<sycl::event>& dependencies = {},
+                         const bundle::executable_t* kernel_bundle = nullptr) {
+  sycl::range<1> kernel_range(N);
+
+  // Compute axpy and then dot in the same kernel
+  sycl::event kernel_event = sycl_queue.submit([&](sycl::handler& cgh) {
+    cgh.depends_on(dependencies);
+    bundle::use(cgh, kernel_bundle);
+
+    auto reduce_normy = sycl::reduction(normy, sycl::plus<>());
+    cgh.parallel_for(kernel_range, reduce_normy,
+                     [=](sycl::id<1> i, auto& normy_) {
+                       T y_i = alpha * x[i] + y[i];
+                       y[i] = y_i;
+                       normy_ += y_i * y_i;
+                     });
+  });
+  return kernel_event;
+}
+
+// Work-group size of the sub-group kernels, a multiple of every sub-group
+// size in forEachSubGroupSize
+constexpr int sub_group_block_size{128};
+
+// Calls f with each sub-group size the sub-group kernels are compiled for,
+// as a std::integral_constant, skipping those sycl_device does not support.
+template <typename F>
+void forEachSubGroupSize(const sycl::device& sycl_device, F f) {
+  const auto sizes =
+      sycl_device.get_info<sycl::info::device::sub_group_sizes>();
+  auto run = [&](auto size) {
+    if (sizes.end() != std::find(sizes.begin(), sizes.end(), size())) {
+      f(size);
+    }
+  };
+  run(std::integral_constant<int, 8>());
+  run(std::integral_constant<int, 16>());
+  run(std::integral_constant<int, 32>());
+  run(std::integral_constant<int, 64>());
+}
+
+// Same as axpyDotFused, but the dot product is reduced within each
+// sub-group of sub_group_size work-items, which needs no barriers or local
+// memory, and the leader of each sub-group adds its sum to *normy with one
+// atomic.
+template <int sub_group_size, typename T>
+sycl::event axpyDotSubGroup(
+    sycl::queue& sycl_queue, int64_t N, T alpha, const T* x, T* y, T* normy,
+    const std::vector<sycl::event>& dependencies = {},
+    const bundle::executable_t* kernel_bundle = nullptr) {
+  const int64_t number_of_blocks =
+      (N + sub_group_block_size - 1) / sub_group_block_size;
+  sycl::range<1> local_range(sub_group_block_size);
+  sycl::range<1> global_range(number_of_blocks * sub_group_block_size);
+  sycl::nd_range<1> kernel_range(global_range, local_range);
+
+  return sycl_queue.submit([&](sycl::handler& cgh) {
+    cgh.depends_on(dependencies);
+    bundle::use(cgh, kernel_bundle);
+
+    cgh.parallel_for(
+        kernel_range, [=](sycl::nd_item<1> work_item)
+                          [[sycl::reqd_sub_group_size(sub_group_size)]] {
+          const int64_t i = work_item.get_global_id(0);
+          T y_i{};
+          if (i < N) {
+            y_i = alpha * x[i] + y[i];
+            y[i] = y_i;
+          }
+
+          auto sub_group = work_item.get_sub_group();
+          const T normy_sub_group =
+              sycl::reduce_over_group(sub_group, y_i * y_i, sycl::plus<T>());
+          if (sub_group.leader()) {
+            sycl::atomic_ref<T, sycl::memory_order::relaxed,
+                             sycl::memory_scope::device,
+                             sycl::access::address_space::global_space>
+                normy_ref(*normy);
+            normy_ref.fetch_add(normy_sub_group);
+          }
+        });
+  });
+}
+
+// Statistics computed by reduceStatistics, combined as a bitmask
+namespace statistic {
+constexpr unsigned dot{1 << 0};     // x^T y
+constexpr unsigned norm2{1 << 1};   // x^T x
+constexpr unsigned sum{1 << 2};     // sum of x
+constexpr unsigned min{1 << 3};     // minimum of x
+constexpr unsigned max{1 << 4};     // maximum of x
+constexpr unsigned argmax{1 << 5};  // maximum of x and its location
+constexpr unsigned all{(1 << 6) - 1};
+}  // namespace statistic
+
+// An entry and its index
+template <typename T>
+struct location_t {
+  T value;
+  int64_t index;
+};
+
+// Combines locations into the one with the largest value, or the smallest
+// index of equal values, so the result does not depend on the order.
+struct argmax_t {
+  template <typename T>
+  location_t<T> operator()(const location_t<T>& a,
+                           const location_t<T>& b) const {
+    if (a.value != b.value) return (a.value > b.value) ? a : b;
+    return (a.index < b.index) ? a : b;
+  }
+};
+
+// Results of reduceStatistics, kept in device memory so that they can be
+// used by later kernels without a copy to the host
+template <typename T>
+struct statistics_t {
+  T dot;
+  T norm2;
+  T sum;
+  T min;
+  T max;
+  location_t<T> argmax;
+};
+
+// The reduction, as a tuple for expr::evaluate, if statistic is requested
+template <unsigned requested, unsigned statistic, typename R>
+auto selectReduction(const R& reduction) {
+  if constexpr (0 != (requested & statistic)) {
+    return std::tuple<R>{reduction};
+  } else {
+    return std::tuple<>();
+  }
+}
+
+// Computes the requested statistics of x (and y, for the dot product) in a
+// single pass, so x and y are read once no matter how many are requested.
+// Each statistic gets its own sycl::reduction; those not requested are not
+// computed, and their members of *result are left unchanged.
+template <unsigned requested, typename T>
+sycl::event reduceStatistics(
+    sycl::queue& sycl_queue, int64_t n, const T* x, const T* y,
+    statistics_t<T>* result,
+    const std::vector<sycl::event>& dependencies = {}) {
+  static_assert(0 != requested && 0 == (requested & ~statistic::all),
+                "Unknown statistic requested");
+
+  auto x_ = expr::vector(x, n);
+  auto y_ = expr::vector(y, n);
+  auto location = expr::map(
+      [](T value, int64_t index) { return location_t<T>{value, index}; },
+      x_, expr::index());
+  const location_t<T> no_location{std::numeric_limits<T>::lowest(),
+                                  std::numeric_limits<int64_t>::max()};
+
+  return expr::evaluate(
+      sycl_queue, n, std::tuple<>(),
+      std::tuple_cat(
+          selectReduction<requested, statistic::dot>(
+              expr::dot(&result->dot, x_, y_)),
+          selectReduction<requested, statistic::norm2>(
+              expr::dot(&result->norm2, x_, x_)),
+          selectReduction<requested, statistic::sum>(
+              expr::sum(&result->sum, x_)),
+          selectReduction<requested, statistic::min>(
+              expr::minimum(&result->min, x_)),
+          selectReduction<requested, statistic::max>(
+              expr::maximum(&result->max, x_)),
+          selectReduction<requested, statistic::argmax>(expr::reduce(
+              &result->argmax, location, argmax_t(), no_location))),
+      dependencies);
+}
+
+// Work-group size of the two-stage reductions, and entries reduced by each
+// work-item in the first stage. Both are fixed rather than chosen for the
+// device, so that reproducible reductions split the work the same way on
+// every device and launch.
+constexpr int reduce_block_size{256};
+constexpr int reduce_items_per_work_item{16};
+
+// Number of partial results written by the first stage for n entries
+inline int64_t numberOfPartials(int64_t n) {
+  constexpr int64_t entries_per_group{int64_t(reduce_block_size) *
+                                      reduce_items_per_work_item};
+  return std::max<int64_t>(1, (n + entries_per_group - 1) / entries_per_group);
+}
+
+// Combines value over a work-group of reduce_block_size work-items.
+// reduce_over_group combines in an implementation-defined order, which may
+// change with the device or compiler; the reproducible version always uses
+// the same binary tree in tile, local memory of reduce_block_size entries
+// which only it allocates.
+template <bool is_reproducible, typename T, typename Op>
+T reduceGroup(sycl::group<1> work_group, T value, Op op) {
+  if constexpr (!is_reproducible) {
+    return sycl::reduce_over_group(work_group, value, op);
+  } else {
+    using tile_t = T[reduce_block_size];
+    tile_t& tile =
+        *dpcpp::group_local_memory_for_overwrite<tile_t>(work_group);
+
+    const int k = work_group.get_local_linear_id();
+    tile[k] = value;
+    for (int stride = reduce_block_size / 2; 0 < stride; stride /= 2) {
+      sycl::group_barrier(work_group);
+      if (k < stride) tile[k] = op(tile[k], tile[k + stride]);
+    }
+    sycl::group_barrier(work_group);
+    return tile[0];
+  }
+}
+
+// First stage: each work-group reduces a block of consecutive entries of the
+// expression e to partials[g], for numberOfPartials(n) groups. Work-items
+// read with a stride of the group size, so reads are coalesced, and combine
+// their entries in index order before the group reduction.
+template <bool is_reproducible, typename T, typename E, typename Op>
+sycl::event reduceToPartials(
+    sycl::queue& sycl_queue, int64_t n, const E& e, Op op, T identity,
+    T* partials, const std::vector<sycl::event>& dependencies = {}) {
+  sycl::range<1> local_range(reduce_block_size);
+  sycl::range<1> global_range(numberOfPartials(n) * reduce_block_size);
+  sycl::nd_range<1> kernel_range(global_range, local_range);
+
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<1> work_item) {
+        const int64_t g = work_item.get_group(0);
+        const int64_t k = work_item.get_local_id(0);
+
+        auto work_group = work_item.get_group();
+
+        const int64_t first =
+            g * reduce_block_size * reduce_items_per_work_item + k;
+        T value = identity;
+        for (int j = 0; j < reduce_items_per_work_item; ++j) {
+          const int64_t i = first + int64_t(j) * reduce_block_size;
+          if (i < n) value = op(value, static_cast<T>(e(i)));
+        }
+
+        value = reduceGroup<is_reproducible>(work_group, value, op);
+        if (work_group.leader()) partials[g] = value;
+      });
+}
+
+// Second stage: a single work-group combines the partials into *result, in
+// a fixed order: each work-item combines every reduce_block_size-th partial
+// in index order, then the group combines with a fixed tree.
+template <typename T, typename Op>
+sycl::event reducePartials(sycl::queue& sycl_queue,
+                           int64_t number_of_partials, const T* partials,
+                           Op op, T identity, T* result,
+                           const std::vector<sycl::event>& dependencies = {}) {
+  sycl::range<1> block_range(reduce_block_size);
+  sycl::nd_range<1> kernel_range(block_range, block_range);
+
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<1> work_item) {
+        const int64_t k = work_item.get_local_id(0);
+        auto work_group = work_item.get_group();
+
+        T value = identity;
+        for (int64_t i = k; i < number_of_partials; i += reduce_block_size) {
+          value = op(value, partials[i]);
+        }
+
+        value = reduceGroup<true>(work_group, value, op);
+        if (work_group.leader()) *result = value;
+      });
+}
+
+// Reduces the expression e over indices 0 to n - 1 into *result, which is
+// overwritten, with an explicit two-stage reduction. partials must hold
+// numberOfPartials(n) entries. If is_reproducible, the result is bitwise
+// identical across runs and devices with the same floating-point behaviour,
+// since the order of every combination is fixed. Returns the events of both
+// stages, so each can be profiled.
+template <bool is_reproducible, typename T, typename E, typename Op>
+std::vector<sycl::event> reduceTwoStage(
+    sycl::queue& sycl_queue, int64_t n, const E& e, Op op, T identity,
+    T* partials, T* result,
+    const std::vector<sycl::event>& dependencies = {}) {
+  sycl::event partials_event = reduceToPartials<is_reproducible>(
+      sycl_queue, n, e, op, identity, partials, dependencies);
+  sycl::event result_event =
+      reducePartials(sycl_queue, numberOfPartials(n), partials, op, identity,
+                     result, {partials_event});
+  return {partials_event, result_event};
+}
+
+// Computes *result = x^T y with reduceTwoStage
+template <bool is_reproducible, typename T>
+std::vector<sycl::event> dotTwoStage(
+    sycl::queue& sycl_queue, int64_t n, const T* x, const T* y, T* partials,
+    T* result, const std::vector<sycl::event>& dependencies = {}) {
+  return reduceTwoStage<is_reproducible>(
+      sycl_queue, n, expr::vector(x, n) * expr::vector(y, n), sycl::plus<T>(),
+      T(0), partials, result, dependencies);
+}
+
+// Work-group size of the nd_range gemv kernels. In the tiled kernel this is
+// the number of rows computed, and entries of x cached in SLM, by each group.
+constexpr int gemv_block_size{128};
+
+// Computes y = alpha * op(A)(x) + beta * y, where A is an m x n matrix.
+// A and x are stored as T, while y is stored as, and arithmetic is done in,
+// Tacc. Using a smaller storage type reduces the memory traffic for A.
+template <typename T, typename Tacc>
+sycl::event gemv(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                 int64_t n, Tacc alpha, const T* a, const T* x, Tacc beta,
+                 Tacc* y, const std::vector<sycl::event>& dependencies = {}) {
+  if (transpose::trans == trans) {
+    // Each work-item walks one column of A, so neighbouring work-items read
+    // addresses m elements apart.
+    sycl::range<1> kernel_range(n);
+    return sycl_queue.parallel_for(
+        kernel_range, dependencies, [=](sycl::id<1> j) {
+          Tacc y_j{};
+          for (int64_t i = 0; i < m; ++i) {
+            y_j += static_cast<Tacc>(a[i + m * j]) * static_cast<Tacc>(x[i]);
+          }
+          y[j] = alpha * y_j + beta * y[j];
+        });
+  }
+
+  sycl::range<1> kernel_range(m);
+  sycl::event gemv_event =
+      sycl_queue.parallel_for(kernel_range, dependencies, [=](sycl::id<1> i) {
+        Tacc y_i = beta * y[i];
+        for (int64_t j = 0; j < n; ++j) {
+          y_i += alpha * static_cast<Tacc>(a[i + m * j]) *
+                 static_cast<Tacc>(x[j]);
+        }
+        y[i] = y_i;
+      });
+  return gemv_event;
+}
+
+// Computes y = alpha * A(x) + beta * y, but each work-group computes
+// gemv_block_size consecutive rows of y and caches x in shared local memory,
+// gemv_block_size entries at a time. The global range is rounded up, so m and
+// n can be any size.
+template <typename T, typename Tacc>
+sycl::event gemvTiled(sycl::queue& sycl_queue, int64_t m, int64_t n,
+                      Tacc alpha, const T* a, const T* x, Tacc beta, Tacc* y,
+                      const std::vector<sycl::event>& dependencies = {}) {
+  const int64_t number_of_blocks = (m + gemv_block_size - 1) / gemv_block_size;
+  sycl::range<1> local_range(gemv_block_size);
+  sycl::range<1> global_range(number_of_blocks * gemv_block_size);
+  sycl::nd_range<1> kernel_range(global_range, local_range);
+
+  sycl::event gemv_event = sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<1> work_item) {
+        const int64_t i = work_item.get_global_id(0);
+        const int k = work_item.get_local_id(0);
+
+        auto work_group = work_item.get_group();
+
+        // Allocate SLM to use as an explicit cache for x, converted to Tacc
+        using tile_t = Tacc[gemv_block_size];
+        tile_t& x_tile =
+            *dpcpp::group_local_memory_for_overwrite<tile_t>(work_group);
+
+        Tacc y_i{};
+        for (int64_t j_tile = 0; j_tile < n; j_tile += gemv_block_size) {
+          // Each work-item loads one entry of x; pad the last tile with zeros
+          const int64_t j = j_tile + k;
+          x_tile[k] = (j < n) ? static_cast<Tacc>(x[j]) : Tacc(0);
+
+          // Synchronize the work-group since we wrote to SLM
+          sycl::group_barrier(work_group);
+
+          // Work-items past the last row still have to reach the barriers
+          if (i < m) {
+            const int64_t tile_width =
+                (n - j_tile < gemv_block_size) ? (n - j_tile) : gemv_block_size;
+            const T* a_tile = a + i + m * j_tile;
+            for (int64_t jj = 0; jj < tile_width; ++jj) {
+              y_i += static_cast<Tacc>(a_tile[m * jj]) * x_tile[jj];
+            }
+          }
+
+          // Synchronize the work-group since we read from SLM
+          sycl::group_barrier(work_group);
+        }
+
+        if (i < m) y[i] = alpha * y_i + beta * y[i];
+      });
+  return gemv_event;
+}
+
+// Computes y = alpha * A^T(x) + beta * y. Each work-group computes one entry
+// of y: its work-items read consecutive entries of a column of A and the
+// partial sums are combined with a group reduction.
+template <typename T, typename Tacc>
+sycl::event gemvTrans(sycl::queue& sycl_queue, int64_t m, int64_t n,
+                      Tacc alpha, const T* a, const T* x, Tacc beta, Tacc* y,
+                      const std::vector<sycl::event>& dependencies = {}) {
+  sycl::range<1> local_range(gemv_block_size);
+  sycl::range<1> global_range(n * gemv_block_size);
+  sycl::nd_range<1> kernel_range(global_range, local_range);
+
+  sycl::event gemv_event = sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<1> work_item) {
+        const int64_t j = work_item.get_group(0);
+        const int64_t k = work_item.get_local_id(0);
+
+        auto work_group = work_item.get_group();
+
+        const T* a_j = a + m * j;
+        Tacc y_j{};
+        for (int64_t i = k; i < m; i += gemv_block_size) {
+          y_j += static_cast<Tacc>(a_j[i]) * static_cast<Tacc>(x[i]);
+        }
+
+        y_j = sycl::reduce_over_group(work_group, y_j, sycl::plus<Tacc>());
+        if (work_group.leader()) y[j] = alpha * y_j + beta * y[j];
+      });
+  return gemv_event;
+}
+
+// Computes y = alpha * op(A)(x) + beta * y with sub-groups of sub_group_size
+// work-items and no local memory or work-group barriers. Transposed, each
+// sub-group computes one entry of y: its work-items read consecutive entries
+// of a column of A and the partial sums are combined with reduce_over_group.
+// Otherwise each work-item computes one row, as in gemvTiled, but entries of
+// x are shared through the sub-group: each work-item loads one entry of a
+// tile of sub_group_size and the others read it with group_broadcast.
+template <int sub_group_size, typename T, typename Tacc>
+sycl::event gemvSubGroup(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                         int64_t n, Tacc alpha, const T* a, const T* x,
+                         Tacc beta, Tacc* y,
+                         const std::vector<sycl::event>& dependencies = {}) {
+  constexpr int sub_groups_per_block{sub_group_block_size / sub_group_size};
+  sycl::range<1> local_range(sub_group_block_size);
+
+  if (transpose::trans == trans) {
+    const int64_t number_of_blocks =
+        (n + sub_groups_per_block - 1) / sub_groups_per_block;
+    sycl::range<1> global_range(number_of_blocks * sub_group_block_size);
+    sycl::nd_range<1> kernel_range(global_range, local_range);
+
+    return sycl_queue.parallel_for(
+        kernel_range, dependencies,
+        [=](sycl::nd_item<1> work_item)
+            [[sycl::reqd_sub_group_size(sub_group_size)]] {
+              auto sub_group = work_item.get_sub_group();
+              const int64_t j =
+                  work_item.get_group(0) * sub_groups_per_block +
+                  sub_group.get_group_linear_id();
+              const int64_t k = sub_group.get_local_linear_id();
+
+              // j is the same for the whole sub-group, so either all of its
+              // work-items return or none do
+              if (j >= n) return;
+              const T* a_j = a + m * j;
+              Tacc y_j{};
+              for (int64_t i = k; i < m; i += sub_group_size) {
+                y_j += static_cast<Tacc>(a_j[i]) * static_cast<Tacc>(x[i]);
+              }
+
+              y_j = sycl::reduce_over_group(sub_group, y_j, sycl::plus<Tacc>());
+              if (sub_group.leader()) y[j] = alpha * y_j + beta * y[j];
+            });
+  }
+
+  const int64_t number_of_blocks =
+      (m + sub_group_block_size - 1) / sub_group_block_size;
+  sycl::range<1> global_range(number_of_blocks * sub_group_block_size);
+  sycl::nd_range<1> kernel_range(global_range, local_range);
+
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies,
+      [=](sycl::nd_item<1> work_item)
+          [[sycl::reqd_sub_group_size(sub_group_size)]] {
+            const int64_t i = work_item.get_global_id(0);
+            auto sub_group = work_item.get_sub_group();
+            const int k = sub_group.get_local_linear_id();
+
+            Tacc y_i{};
+            for (int64_t j_tile = 0; j_tile < n; j_tile += sub_group_size) {
+              // Each work-item loads one entry of x; pad the last tile with
+              // zeros. Work-items past the last row still take part, since
+              // the whole sub-group must reach each group_broadcast.
+              const int64_t j = j_tile + k;
+              const Tacc x_j = (j < n) ? static_cast<Tacc>(x[j]) : Tacc(0);
+
+              const int64_t tile_width =
+                  (n - j_tile < sub_group_size) ? (n - j_tile) : sub_group_size;
+              const T* a_tile = a + i + m * j_tile;
+              for (int jj = 0; jj < sub_group_size; ++jj) {
+                const Tacc x_jj = sycl::group_broadcast(sub_group, x_j, jj);
+                if (i < m && jj < tile_width) {
+                  y_i += static_cast<Tacc>(a_tile[m * jj]) * x_jj;
+                }
+              }
+            }
+
+            if (i < m) y[i] = alpha * y_i + beta * y[i];
+          });
+}
+
+// Launches the naive gemv kernel, or the tiled (non-transposed) or work-group
+// reduction (transposed) kernel if is_tiled.
+template <typename T, typename Tacc, bool is_tiled>
+sycl::event launchGemv(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                       int64_t n, Tacc alpha, const T* a, const T* x,
+                       Tacc beta, Tacc* y,
+                       const std::vector<sycl::event>& dependencies = {}) {
+  if (!is_tiled) {
+    return gemv(sycl_queue, trans, m, n, alpha, a, x, beta, y, dependencies);
+  } else if (transpose::nontrans == trans) {
+    return gemvTiled(sycl_queue, m, n, alpha, a, x, beta, y, dependencies);
+  } else {
+    return gemvTrans(sycl_queue, m, n, alpha, a, x, beta, y, dependencies);
+  }
+}
+
+// Computes entry i of y = alpha * op(A)(x) + beta * y, for the batched
+// kernels below.
+template <typename T>
+inline void gemvEntry(transpose trans, int64_t m, int64_t n, T alpha,
+                      const T* a, const T* x, T beta, T* y, int64_t i) {
+  T y_i{};
+  if (transpose::nontrans == trans) {
+    for (int64_t j = 0; j < n; ++j) {
+      y_i += a[i + m * j] * x[j];
+    }
+  } else {
+    for (int64_t j = 0; j < m; ++j) {
+      y_i += a[j + m * i] * x[j];
+    }
+  }
+  y[i] = alpha * y_i + beta * y[i];
+}
+
+// Given a group of matrices and vectors of the same size, compute
+// for (b=0; b < batch_size; ++b) {
+//   Y = alpha * op(A)(X) + beta * Y
+// }
+// where A, X and Y are located at offsets stride_a * b, stride_x * b and
+// stride_y * b in a, x and y. The whole batch is computed by a single kernel,
+// with the batch index as the "slowest" dimension of the nd_range.
+template <typename T>
+sycl::event gemv_batch(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                       int64_t n, T alpha, const T* a, int64_t stride_a,
+                       const T* x, int64_t stride_x, T beta, T* y,
+                       int64_t stride_y, int64_t batch_size,
+                       const std::vector<sycl::event>& dependencies = {}) {
+  const int64_t y_size = (transpose::nontrans == trans) ? m : n;
+  const int64_t local_size = std::min<int64_t>(gemv_block_size, y_size);
+  const int64_t number_of_blocks = (y_size + local_size - 1) / local_size;
+  sycl::range<2> local_range(1, local_size);
+  sycl::range<2> global_range(batch_size, number_of_blocks * local_size);
+  sycl::nd_range<2> kernel_range(global_range, local_range);
+
+  sycl::event gemv_event = sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<2> work_item) {
+        const int64_t batch_i = work_item.get_global_id(0);
+        const int64_t i = work_item.get_global_id(1);
+        if (i < y_size) {
+          gemvEntry(trans, m, n, alpha, a + stride_a * batch_i,
+                    x + stride_x * batch_i, beta, y + stride_y * batch_i, i);
+        }
+      });
+  return gemv_event;
+}
+
+// Same as above, but the b-th matrix and vectors are given by a_array[b],
+// x_array[b] and y_array[b]. The pointer arrays must be accessible on the
+// device.
+template <typename T>
+sycl::event gemv_batch(sycl::queue& sycl_queue, transpose trans, int64_t m,
+                       int64_t n, T alpha, const T* const* a_array,
+                       const T* const* x_array, T beta, T* const* y_array,
+                       int64_t batch_size,
+                       const std::vector<sycl::event>& dependencies = {}) {
+  const int64_t y_size = (transpose::nontrans == trans) ? m : n;
+  const int64_t local_size = std::min<int64_t>(gemv_block_size, y_size);
+  const int64_t number_of_blocks = (y_size + local_size - 1) / local_size;
+  sycl::range<2> local_range(1, local_size);
+  sycl::range<2> global_range(batch_size, number_of_blocks * local_size);
+  sycl::nd_range<2> kernel_range(global_range, local_range);
+
+  sycl::event gemv_event = sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<2> work_item) {
+        const int64_t batch_i = work_item.get_global_id(0);
+        const int64_t i = work_item.get_global_id(1);
+        if (i < y_size) {
+          gemvEntry(trans, m, n, alpha, a_array[batch_i], x_array[batch_i],
+                    beta, y_array[batch_i], i);
+        }
+      });
+  return gemv_event;
+}
+
+// Computes C = alpha * A * B + beta * C, where A is m x k, B is k x n and C is
+// m x n, with leading dimensions lda, ldb and ldc. Each work-item computes one
+// entry of C.
+template <typename T>
+sycl::event gemmNaive(sycl::queue& sycl_queue, int64_t m, int64_t n, int64_t k,
+                      T alpha, const T* a, int64_t lda, const T* b,
+                      int64_t ldb, T beta, T* c, int64_t ldc,
+                      const std::vector<sycl::event>& dependencies = {}) {
+  sycl::range<2> kernel_range(n, m);
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::id<2> ij) {
+        // In SYCL the last dimension is always the "fastest"
+        const int64_t i = ij[1];
+        const int64_t j = ij[0];
+
+        T C_ij{};
+        for (int64_t l = 0; l < k; ++l) {
+          C_ij += a[i + lda * l] * b[l + ldb * j];
+        }
+        c[i + ldc * j] = alpha * C_ij + beta * c[i + ldc * j];
+      });
+}
+
+// Same as above, but each work-group computes a block_m x block_n block of C,
+// caching tile_k columns of A and rows of B in shared local memory at a time.
+// Each work-item computes a reg_m x reg_n tile of C held in registers, so
+// each value loaded from SLM is reused reg_m or reg_n times. Edge blocks are
+// padded with zeros, so m, n and k can be any size.
+template <typename T, int block_m, int block_n, int tile_k, int reg_m,
+          int reg_n>
+sycl::event gemm(sycl::queue& sycl_queue, int64_t m, int64_t n, int64_t k,
+                 T alpha, const T* a, int64_t lda, const T* b, int64_t ldb,
+                 T beta, T* c, int64_t ldc,
+                 const std::vector<sycl::event>& dependencies = {}) {
+  static_assert(0 == block_m % reg_m, "block_m must be a multiple of reg_m");
+  static_assert(0 == block_n % reg_n, "block_n must be a multiple of reg_n");
+
+  // Work-items per work-group in each dimension
+  constexpr int local_m = block_m / reg_m;
+  constexpr int local_n = block_n / reg_n;
+  constexpr int local_size = local_m * local_n;
+
+  const int64_t blocks_m = (m + block_m - 1) / block_m;
+  const int64_t blocks_n = (n + block_n - 1) / block_n;
+
+  sycl::range<2> local_range(local_n, local_m);
+  sycl::range<2> global_range(blocks_n * local_n, blocks_m * local_m);
+  sycl::nd_range<2> kernel_range(global_range, local_range);
+
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<2> work_item) {
+        // The last dimension of an ND-range is the "fastest"
+        const int i_local = work_item.get_local_id(1);
+        const int j_local = work_item.get_local_id(0);
+        const int local_id = i_local + local_m * j_local;
+
+        const int64_t i_block = block_m * work_item.get_group(1);
+        const int64_t j_block = block_n * work_item.get_group(0);
+
+        auto work_group = work_item.get_group();
+
+        // Allocate SLM to use as an explicit cache
+        using a_tile_t = T[tile_k][block_m];
+        using b_tile_t = T[block_n][tile_k];
+        a_tile_t& A_tile =
+            *dpcpp::group_local_memory_for_overwrite<a_tile_t>(work_group);
+        b_tile_t& B_tile =
+            *dpcpp::group_local_memory_for_overwrite<b_tile_t>(work_group);
+
+        // Work-item (i_local, j_local) computes the entries of C in rows
+        // i_block + i_local + local_m * r and columns j_block + j_local +
+        // local_n * s, so neighbouring work-items access neighbouring rows.
+        T C_reg[reg_m][reg_n]{};
+
+        for (int64_t k_tile = 0; k_tile < k; k_tile += tile_k) {
+          // Load one tile of A from global to shared local memory
+          for (int index = local_id; index < tile_k * block_m;
+               index += local_size) {
+            const int i = index % block_m;
+            const int l = index / block_m;
+            const int64_t i_global = i_block + i;
+            const int64_t l_global = k_tile + l;
+            A_tile[l][i] = (i_global < m && l_global < k)
+                               ? a[i_global + lda * l_global]
+                               : T(0);
+          }
+
+          // Load one tile of B from global to shared local memory
+          for (int index = local_id; index < block_n * tile_k;
+               index += local_size) {
+            const int l = index % tile_k;
+            const int j = index / tile_k;
+            const int64_t l_global = k_tile + l;
+            const int64_t j_global = j_block + j;
+            B_tile[j][l] = (l_global < k && j_global < n)
+                               ? b[l_global + ldb * j_global]
+                               : T(0);
+          }
+
+          // Synchronize the work-group since we wrote to SLM
+          sycl::group_barrier(work_group);
+
+          for (int l = 0; l < tile_k; ++l) {
+            T A_reg[reg_m];
+            T B_reg[reg_n];
+            for (int r = 0; r < reg_m; ++r) {
+              A_reg[r] = A_tile[l][i_local + local_m * r];
+            }
+            for (int s = 0; s < reg_n; ++s) {
+              B_reg[s] = B_tile[j_local + local_n * s][l];
+            }
+            for (int r = 0; r < reg_m; ++r) {
+              for (int s = 0; s < reg_n; ++s) {
+                C_reg[r][s] += A_reg[r] * B_reg[s];
+              }
+            }
+          }
+
+          // Synchronize the work-group since we read from SLM
+          sycl::group_barrier(work_group);
+        }
+
+        // Each work-item writes its results back to global memory
+        for (int s = 0; s < reg_n; ++s) {
+          const int64_t j_global = j_block + j_local + local_n * s;
+          if (j_global >= n) break;
+          for (int r = 0; r < reg_m; ++r) {
+            const int64_t i_global = i_block + i_local + local_m * r;
+            if (i_global >= m) break;
+            T& C_ij = c[i_global + ldc * j_global];
+            // Do not read C when beta is zero, since it may be uninitialized
+            C_ij = (T(0) == beta) ? alpha * C_reg[r][s]
+                                  : alpha * C_reg[r][s] + beta * C_ij;
+          }
+        }
+      });
+}
+
+}  // namespace device_blas
+
+#endif
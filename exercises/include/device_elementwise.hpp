@@ -0,0 +1,97 @@
+#ifndef _DEVICE_ELEMENTWISE_HPP_
+#define _DEVICE_ELEMENTWISE_HPP_
+
+#include <CL/sycl.hpp>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Elementwise kernels in which each work-item loads, computes and stores
+// width contiguous entries as a sycl::vec. Unlike the device_functions
+// example, where each work-item reads entries a whole range apart into
+// private arrays, the loads and stores are contiguous and can be issued as
+// single vector instructions. Vectors of any length are handled: the last
+// n % width entries are done one per work-item by the same kernel.
+namespace device_elementwise {
+
+// The vector widths sycl::vec supports
+template <int width>
+constexpr bool is_valid_width_v = (1 == width) || (2 == width) ||
+                                  (4 == width) || (8 == width) ||
+                                  (16 == width);
+
+template <int width, typename T>
+using vector_t = sycl::vec<std::remove_const_t<T>, width>;
+
+// The k-th vector of width entries starting at data, i.e., data[k * width]
+// to data[k * width + width - 1]
+template <int width, typename T>
+vector_t<width, T> load(T* data, int64_t k) {
+  vector_t<width, T> v;
+  v.load(k, sycl::address_space_cast<sycl::access::address_space::global_space,
+                                     sycl::access::decorated::no>(data));
+  return v;
+}
+
+template <int width, typename T>
+void store(const vector_t<width, T>& v, T* data, int64_t k) {
+  v.store(k, sycl::address_space_cast<sycl::access::address_space::global_space,
+                                      sycl::access::decorated::no>(data));
+}
+
+// y[i] = f(x[i]...) for i from 0 to n - 1. f is called on vectors of width
+// entries, and on single entries for the remainder, so it must accept both,
+// e.g. a generic lambda using only arithmetic operators. y may be one of x.
+template <int width, typename T, typename F, typename... Inputs>
+sycl::event transform(sycl::queue& sycl_queue, int64_t n,
+                      const std::vector<sycl::event>& dependencies, F f, T* y,
+                      const Inputs*... x) {
+  static_assert(is_valid_width_v<width>, "Unsupported vector width");
+  const int64_t number_of_vectors = n / width;
+  const int64_t remainder = n - number_of_vectors * width;
+
+  return sycl_queue.parallel_for(
+      sycl::range<1>(number_of_vectors + remainder), dependencies,
+      [=](sycl::id<1> it) {
+        const int64_t k = it[0];
+        if (k < number_of_vectors) {
+          store<width>(vector_t<width, T>(f(load<width>(x, k)...)), y, k);
+        } else {
+          const int64_t i = number_of_vectors * width + k - number_of_vectors;
+          y[i] = f(x[i]...);
+        }
+      });
+}
+
+// y = alpha * x + y
+template <int width, typename T>
+sycl::event axpy(sycl::queue& sycl_queue, int64_t n, T alpha, const T* x,
+                 T* y, const std::vector<sycl::event>& dependencies = {}) {
+  return transform<width>(
+      sycl_queue, n, dependencies,
+      [=](auto x_i, auto y_i) { return alpha * x_i + y_i; }, y, x,
+      static_cast<const T*>(y));
+}
+
+// a = b + s * c, as in the kernels and events examples
+template <int width, typename T>
+sycl::event triad(sycl::queue& sycl_queue, int64_t n, T s, const T* b,
+                  const T* c, T* a,
+                  const std::vector<sycl::event>& dependencies = {}) {
+  return transform<width>(
+      sycl_queue, n, dependencies,
+      [=](auto b_i, auto c_i) { return b_i + s * c_i; }, a, b, c);
+}
+
+// y = alpha * x
+template <int width, typename T>
+sycl::event scale(sycl::queue& sycl_queue, int64_t n, T alpha, const T* x,
+                  T* y, const std::vector<sycl::event>& dependencies = {}) {
+  return transform<width>(
+      sycl_queue, n, dependencies, [=](auto x_i) { return alpha * x_i; }, y,
+      x);
+}
+
+}  // namespace device_elementwise
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef _DEVICE_GATHER_SCATTER_HPP_
+#define _DEVICE_GATHER_SCATTER_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "memory_pool.hpp"
+
+// Gather-scatter, or direct stiffness summation, for fields stored element
+// by element as in the group_collectives example. A node on the boundary of
+// an element is shared with its neighbours and stored once per element; the
+// gather-scatter sums the copies of every shared node and writes the sum
+// back to each copy.
+//
+// Summing into a global vector with atomics makes every copy an atomic
+// read-modify-write, and the copies of a node contend for the same address.
+// Instead, the setup sorts the local nodes by global node id, so the copies
+// of each shared node form a contiguous segment of the sorted order. Each
+// work-item of the apply then reduces one segment and scatters the sum, with
+// no atomics and no global vector.
+namespace device_gather_scatter {
+
+// The shared nodes, sorted by global node id. The copies of segment s are
+// the local nodes order[offsets[s]] to order[offsets[s + 1] - 1]. Nodes
+// which are not shared are left out, since the sum of one copy is itself.
+struct segments_t {
+  std::vector<int32_t> order;
+  std::vector<int32_t> offsets;
+
+  int64_t numberOfSegments() const { return int64_t(offsets.size()) - 1; }
+};
+
+// global_ids[l] is the global node id of local node l. Local nodes are
+// numbered with 32 bits, so there may be at most INT32_MAX of them.
+inline segments_t sortSegments(const std::vector<int64_t>& global_ids) {
+  if (global_ids.size() > size_t(std::numeric_limits<int32_t>::max())) {
+    throw std::length_error("Too many local nodes for 32-bit indices");
+  }
+  std::vector<int32_t> sorted(global_ids.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::stable_sort(sorted.begin(), sorted.end(), [&](int32_t a, int32_t b) {
+    return global_ids[a] < global_ids[b];
+  });
+
+  segments_t segments;
+  segments.offsets.push_back(0);
+  for (size_t first = 0; first < sorted.size();) {
+    size_t last = first + 1;
+    while (last < sorted.size() &&
+           global_ids[sorted[last]] == global_ids[sorted[first]]) {
+      ++last;
+    }
+    if (1 < last - first) {
+      segments.order.insert(segments.order.end(), sorted.begin() + first,
+                            sorted.begin() + last);
+      segments.offsets.push_back(int32_t(segments.order.size()));
+    }
+    first = last;
+  }
+  return segments;
+}
+
+// Holds the segments in device memory from pool, which must outlive it. The
+// memory is returned to the pool on destruction.
+class gather_scatter_t {
+ public:
+  gather_scatter_t(sycl::queue& sycl_queue, memory_pool::device_pool_t& pool,
+                   const std::vector<int64_t>& global_ids)
+      : sycl_queue_{sycl_queue}, pool_{pool} {
+    segments_t segments = sortSegments(global_ids);
+    number_of_segments_ = segments.numberOfSegments();
+    number_of_shared_ = int64_t(segments.order.size());
+
+    order_ = pool_.allocate<int32_t>(number_of_shared_);
+    offsets_ = pool_.allocate<int32_t>(segments.offsets.size());
+    sycl_queue_.copy(segments.order.data(), order_, number_of_shared_);
+    sycl_queue_.copy(segments.offsets.data(), offsets_,
+                     segments.offsets.size());
+    sycl_queue_.wait();
+  }
+
+  gather_scatter_t(const gather_scatter_t&) = delete;
+  gather_scatter_t& operator=(const gather_scatter_t&) = delete;
+
+  ~gather_scatter_t() {
+    pool_.deallocate(order_);
+    pool_.deallocate(offsets_);
+  }
+
+  // Number of nodes with more than one copy
+  int64_t numberOfSegments() const { return number_of_segments_; }
+
+  // Number of copies of those nodes, i.e., local nodes read and written
+  int64_t numberOfShared() const { return number_of_shared_; }
+
+  // Replaces every copy of a shared node in u with the sum of its copies.
+  // Copies of nodes which are not shared are neither read nor written.
+  template <typename T>
+  sycl::event apply(T* u,
+                    const std::vector<sycl::event>& dependencies = {}) {
+    const int32_t* order = order_;
+    const int32_t* offsets = offsets_;
+    return sycl_queue_.parallel_for(
+        sycl::range<1>(number_of_segments_), dependencies,
+        [=](sycl::id<1> it) {
+          const int64_t s = it[0];
+          const int32_t first = offsets[s];
+          const int32_t last = offsets[s + 1];
+          T sum{0};
+          for (int32_t k = first; k < last; ++k) sum += u[order[k]];
+          for (int32_t k = first; k < last; ++k) u[order[k]] = sum;
+        });
+  }
+
+ private:
+  sycl::queue sycl_queue_;
+  memory_pool::device_pool_t& pool_;
+  int64_t number_of_segments_;
+  int64_t number_of_shared_;
+  int32_t* order_;
+  int32_t* offsets_;
+};
+
+}  // namespace device_gather_scatter
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef _DEVICE_SCAN_HPP_
+#define _DEVICE_SCAN_HPP_
+
+#include <CL/sycl.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "device_blas.hpp"
+#include "expression.hpp"
+
+// Device-wide scans (prefix sums) and stream compaction. A group scan such as
+// exclusive_scan_over_group only sees its own work-group, but the output of
+// a device-wide scan depends on every earlier group. Scans are computed with
+// reduce-then-scan in three kernels:
+//
+//   1. each work-group reduces its block of entries to a partial;
+//   2. one work-group scans the partials, giving each block its offset;
+//   3. each work-group scans its block again, starting from its offset.
+//
+// A single-pass scan with decoupled look-back reads the input once instead
+// of twice, but it needs later work-groups to spin on flags set by earlier
+// ones, which relies on forward progress guarantees SYCL does not make.
+namespace device_scan {
+
+// Number of partials used to scan n entries. Blocks are the same as those of
+// the two-stage reductions in device_blas.
+inline int64_t numberOfPartials(int64_t n) {
+  return device_blas::numberOfPartials(n);
+}
+
+// Exclusive scan of partials in place, by one work-group. Each work-item
+// scans a contiguous run of partials, the runs' totals are scanned across the
+// group, and the runs are then offset. The total is written to *total.
+template <typename T, typename Op>
+sycl::event scanPartials(sycl::queue& sycl_queue, int64_t number_of_partials,
+                         T* partials, Op op, T identity, T* total,
+                         const std::vector<sycl::event>& dependencies = {}) {
+  constexpr int block_size{device_blas::reduce_block_size};
+  sycl::range<1> block_range(block_size);
+  sycl::nd_range<1> kernel_range(block_range, block_range);
+
+  return sycl_queue.parallel_for(
+      kernel_range, dependencies, [=](sycl::nd_item<1> work_item) {
+        const int64_t k = work_item.get_local_id(0);
+        auto work_group = work_item.get_group();
+
+        const int64_t run = (number_of_partials + block_size - 1) / block_size;
+        const int64_t first = k * run;
+        const int64_t last = std::min(first + run, number_of_partials);
+
+        T run_total = identity;
+        for (int64_t i = first; i < last; ++i) {
+          run_total = op(run_total, partials[i]);
+        }
+        T prefix = sycl::exclusive_scan_over_group(work_group, run_total, op);
+        if (block_size - 1 == k) *total = op(prefix, run_total);
+
+        for (int64_t i = first; i < last; ++i) {
+          const T partial = partials[i];
+          partials[i] = prefix;
+          prefix = op(prefix, partial);
+        }
+      });
+}
+
+// Computes the exclusive scan of the expression e over indices 0 to n - 1,
+// calling apply(i, prefix, value) for every i with the combination of all
+// entries before i and e(i). partials must hold numberOfPartials(n) entries,
+// and the combination of all entries is written to *total.
+template <typename T, typename E, typename Op, typename F>
+sycl::event scanApply(sycl::queue& sycl_queue, int64_t n, const E& e, Op op,
+                      T identity, T* partials, T* total, F apply,
+                      const std::vector<sycl::event>& dependencies = {}) {
+  constexpr int block_size{device_blas::reduce_block_size};
+  constexpr int items_per_work_item{device_blas::reduce_items_per_work_item};
+  const int64_t number_of_partials = numberOfPartials(n);
+
+  sycl::event reduce_event = device_blas::reduceToPartials<false>(
+      sycl_queue, n, e, op, identity, partials, dependencies);
+  sycl::event partials_event = scanPartials(
+      sycl_queue, number_of_partials, partials, op, identity, total,
+      {reduce_event});
+
+  sycl::range<1> local_range(block_size);
+  sycl::range<1> global_range(number_of_partials * block_size);
+  sycl::nd_range<1> kernel_range(global_range, local_range);
+
+  return sycl_queue.parallel_for(
+      kernel_range, partials_event, [=](sycl::nd_item<1> work_item) {
+        const int64_t g = work_item.get_group(0);
+        const int64_t k = work_item.get_local_id(0);
+        auto work_group = work_item.get_group();
+
+        // Consecutive work-items take consecutive entries, and the block is
+        // walked block_size entries at a time, carrying the running total.
+        T carry = partials[g];
+        const int64_t first = g * block_size * items_per_work_item + k;
+        for (int j = 0; j < items_per_work_item; ++j) {
+          const int64_t i = first + int64_t(j) * block_size;
+          const T value = (i < n) ? static_cast<T>(e(i)) : identity;
+          const T prefix =
+              sycl::exclusive_scan_over_group(work_group, value, op);
+          if (i < n) apply(i, op(carry, prefix), value);
+          carry = op(carry, sycl::group_broadcast(work_group, op(prefix, value),
+                                                  block_size - 1));
+        }
+      });
+}
+
+// y[i] = x[0] + ... + x[i - 1], or + x[i] if is_inclusive. workspace must
+// hold numberOfPartials(n) + 1 entries; the last is set to the sum of x.
+// x and y may be the same.
+template <bool is_inclusive, typename T>
+sycl::event scan(sycl::queue& sycl_queue, int64_t n, const T* x, T* y,
+                 T* workspace,
+                 const std::vector<sycl::event>& dependencies = {}) {
+  const int64_t number_of_partials = numberOfPartials(n);
+  return scanApply(
+      sycl_queue, n, expr::vector(x, n), sycl::plus<T>(), T(0), workspace,
+      workspace + number_of_partials,
+      [=](int64_t i, T prefix, T value) {
+        y[i] = is_inclusive ? prefix + value : prefix;
+      },
+      dependencies);
+}
+
+template <typename T>
+sycl::event exclusiveScan(sycl::queue& sycl_queue, int64_t n, const T* x,
+                          T* y, T* workspace,
+                          const std::vector<sycl::event>& dependencies = {}) {
+  return scan<false>(sycl_queue, n, x, y, workspace, dependencies);
+}
+
+template <typename T>
+sycl::event inclusiveScan(sycl::queue& sycl_queue, int64_t n, const T* x,
+                          T* y, T* workspace,
+                          const std::vector<sycl::event>& dependencies = {}) {
+  return scan<true>(sycl_queue, n, x, y, workspace, dependencies);
+}
+
+// Copies the entries of x for which predicate is true to the front of y,
+// keeping their order, and writes how many there are to *count. The
+// position of each selected entry is the exclusive scan of the predicate,
+// so the selected entries are written by the last kernel of the scan
+// without storing the positions. workspace must hold numberOfPartials(n)
+// entries, and predicate must be callable in a kernel.
+template <typename T, typename Predicate>
+sycl::event compactIf(sycl::queue& sycl_queue, int64_t n, const T* x, T* y,
+                      int64_t* count, Predicate predicate,
+                      int64_t* workspace,
+                      const std::vector<sycl::event>& dependencies = {}) {
+  auto is_selected = expr::map(
+      [=](T x_i) { return int64_t(predicate(x_i) ? 1 : 0); },
+      expr::vector(x, n));
+  return scanApply(
+      sycl_queue, n, is_selected, sycl::plus<int64_t>(), int64_t(0),
+      workspace, count,
+      [=](int64_t i, int64_t position, int64_t selected) {
+        if (selected) y[position] = x[i];
+      },
+      dependencies);
+}
+
+}  // namespace device_scan
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef _EXPRESSION_HPP_
+#define _EXPRESSION_HPP_
+
+#include <CL/sycl.hpp>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Expression templates over device vectors. Arithmetic on expressions builds
+// a type describing the computation instead of computing anything, e.g.
+//
+//   auto z = a * x + b * y;  // binary_t<plus, binary_t<...>, binary_t<...>>
+//
+// evaluate() then compiles any number of such expressions, each assigned to
+// a vector or reduced to a scalar, into a single parallel_for. Every work-item
+// evaluates all expressions at its index, so each input is read once and
+// intermediate vectors only go through memory if they are assigned.
+namespace expr {
+
+// Base of all expression types; used to tell them apart from scalars
+struct expression_t {};
+
+template <typename E>
+constexpr bool is_expression_v =
+    std::is_base_of_v<expression_t, std::decay_t<E>>;
+
+// A vector of size entries in device memory. T may be const for inputs.
+template <typename T>
+struct vector_t : expression_t {
+  T* data;
+  int64_t size;
+
+  std::remove_const_t<T> operator()(int64_t i) const { return data[i]; }
+};
+
+template <typename T>
+vector_t<T> vector(T* data, int64_t size) {
+  return {{}, data, size};
+}
+
+// A scalar, the same at every index
+template <typename T>
+struct scalar_t : expression_t {
+  T value;
+
+  T operator()(int64_t) const { return value; }
+};
+
+// The index itself, e.g. to reduce entries to their location
+struct index_t : expression_t {
+  int64_t operator()(int64_t i) const { return i; }
+};
+
+inline index_t index() { return {}; }
+
+template <typename F, typename E>
+struct unary_t : expression_t {
+  F f;
+  E e;
+
+  auto operator()(int64_t i) const { return f(e(i)); }
+};
+
+template <typename F, typename L, typename R>
+struct binary_t : expression_t {
+  F f;
+  L l;
+  R r;
+
+  auto operator()(int64_t i) const { return f(l(i), r(i)); }
+};
+
+// Leaves expressions as they are and turns scalars into scalar_t
+template <typename E>
+auto wrap(const E& e) {
+  if constexpr (is_expression_v<E>) {
+    return e;
+  } else {
+    return scalar_t<E>{{}, e};
+  }
+}
+
+// Applies f to the entries of e, or of l and r, e.g. to call sycl::sqrt or
+// sycl::fmax elementwise. f must be callable in a kernel.
+template <typename F, typename E>
+auto map(F f, const E& e) {
+  return unary_t<F, decltype(wrap(e))>{{}, f, wrap(e)};
+}
+
+template <typename F, typename L, typename R>
+auto map(F f, const L& l, const R& r) {
+  return binary_t<F, decltype(wrap(l)), decltype(wrap(r))>{
+      {}, f, wrap(l), wrap(r)};
+}
+
+// Elementwise arithmetic, with at least one operand an expression and the
+// other an expression or a scalar
+template <typename L, typename R>
+using enable_if_expression_t =
+    std::enable_if_t<is_expression_v<L> || is_expression_v<R>, int>;
+
+template <typename L, typename R, enable_if_expression_t<L, R> = 0>
+auto operator+(const L& l, const R& r) {
+  return map(std::plus<>(), l, r);
+}
+
+template <typename L, typename R, enable_if_expression_t<L, R> = 0>
+auto operator-(const L& l, const R& r) {
+  return map(std::minus<>(), l, r);
+}
+
+template <typename L, typename R, enable_if_expression_t<L, R> = 0>
+auto operator*(const L& l, const R& r) {
+  return map(std::multiplies<>(), l, r);
+}
+
+template <typename L, typename R, enable_if_expression_t<L, R> = 0>
+auto operator/(const L& l, const R& r) {
+  return map(std::divides<>(), l, r);
+}
+
+template <typename E, std::enable_if_t<is_expression_v<E>, int> = 0>
+auto operator-(const E& e) {
+  return map(std::negate<>(), e);
+}
+
+// dst[i] = e(i)
+template <typename T, typename E>
+struct assign_t {
+  T* dst;
+  E e;
+
+  void operator()(int64_t i) const { dst[i] = e(i); }
+};
+
+template <typename T, typename E>
+auto assign(const vector_t<T>& dst, const E& e) {
+  return assign_t<T, decltype(wrap(e))>{dst.data, wrap(e)};
+}
+
+// *result = the reduction of e(i) over all i with op, starting from
+// identity. The previous value of *result is overwritten.
+template <typename T, typename E, typename Op>
+struct reduce_t {
+  T* result;
+  E e;
+  Op op;
+  T identity;
+};
+
+template <typename T, typename E, typename Op>
+auto reduce(T* result, const E& e, Op op, T identity) {
+  return reduce_t<T, decltype(wrap(e)), Op>{result, wrap(e), op, identity};
+}
+
+// As above, for an operation whose identity is known to SYCL
+template <typename T, typename E, typename Op>
+auto reduce(T* result, const E& e, Op op) {
+  return reduce(result, e, op, sycl::known_identity_v<Op, T>);
+}
+
+template <typename T, typename E>
+auto sum(T* result, const E& e) {
+  return reduce(result, e, sycl::plus<T>());
+}
+
+template <typename T, typename L, typename R>
+auto dot(T* result, const L& l, const R& r) {
+  return sum(result, wrap(l) * wrap(r));
+}
+
+template <typename T, typename E>
+auto minimum(T* result, const E& e) {
+  return reduce(result, e, sycl::minimum<T>());
+}
+
+template <typename T, typename E>
+auto maximum(T* result, const E& e) {
+  return reduce(result, e, sycl::maximum<T>());
+}
+
+// Evaluates all assignments and reductions, for indices 0 to n - 1, in one
+// kernel. Assignments are done in order at each index, so an assignment may
+// read a vector written by an earlier one at the same index, but never at
+// another index.
+template <typename... Assignments, typename... Reductions>
+sycl::event evaluate(sycl::queue& sycl_queue, int64_t n,
+                     const std::tuple<Assignments...>& assignments,
+                     const std::tuple<Reductions...>& reductions,
+                     const std::vector<sycl::event>& dependencies = {}) {
+  return sycl_queue.submit([&](sycl::handler& cgh) {
+    cgh.depends_on(dependencies);
+    const sycl::property_list initialize{
+        sycl::property::reduction::initialize_to_identity()};
+
+    // Unpack the tuples on the host, so the kernel captures the assignments
+    // and reductions themselves
+    std::apply(
+        [&](const auto&... assignment) {
+          std::apply(
+              [&](const auto&... reduction) {
+                cgh.parallel_for(
+                    sycl::range<1>(n),
+                    sycl::reduction(reduction.result, reduction.identity,
+                                    reduction.op, initialize)...,
+                    [=](sycl::id<1> it, auto&... reducers) {
+                      const int64_t i = it[0];
+                      (assignment(i), ...);
+                      (reducers.combine(reduction.e(i)), ...);
+                    });
+              },
+              reductions);
+        },
+        assignments);
+  });
+}
+
+template <typename... Assignments>
+sycl::event evaluate(sycl::queue& sycl_queue, int64_t n,
+                     const std::tuple<Assignments...>& assignments,
+                     const std::vector<sycl::event>& dependencies = {}) {
+  return evaluate(sycl_queue, n, assignments, std::tuple<>(), dependencies);
+}
+
+}  // namespace expr
+
+#endif
@@ -4,23 +4,42 @@
 #include <getopt.h>
 
 #include <iostream>
+#include <string>
 
 namespace {
 
 struct arguments_t {
   size_t N = 262144;
   size_t trials = 5000;
+  size_t warmup = 0;
+  double outlier_threshold = 0.0;
+  std::string stats_file;
+  bool profile = false;
+  size_t window = 0;  // trials in flight in throughput mode, 0 to disable
+  size_t runs = 1;
+  bool no_pool = false;
+  bool lazy_jit = false;  // skip building kernels before the first launch
 };
 
 arguments_t readArguments(int argc, char* argv[]) {
   static struct option long_options[] = {
       {"vector-size", required_argument, 0, 'N'},
-      {"trials", required_argument, 0, 'T'}};
+      {"trials", required_argument, 0, 'T'},
+      {"warmup", required_argument, 0, 'W'},
+      {"outlier-threshold", required_argument, 0, 'O'},
+      {"stats-file", required_argument, 0, 'S'},
+      {"profile", no_argument, 0, 'P'},
+      {"window", required_argument, 0, 'w'},
+      {"runs", required_argument, 0, 'R'},
+      {"no-pool", no_argument, 0, 'D'},
+      {"lazy-jit", no_argument, 0, 'J'},
+      {0, 0, 0, 0}};
 
   arguments_t arguments;
   while (1) {
     int option_index{};
-    int c = getopt_long(argc, argv, "N:T:", long_options, &option_index);
+    int c = getopt_long(argc, argv, "N:T:W:O:S:Pw:R:DJ", long_options,
+                        &option_index);
     if (0 > c) break;
 
     switch (c) {
@@ -30,8 +49,34 @@ arguments_t readArguments(int argc, char* argv[]) {
       case 'T':
         arguments.trials = std::stoul(optarg);
         break;
+      case 'W':
+        arguments.warmup = std::stoul(optarg);
+        break;
+      case 'O':
+        arguments.outlier_threshold = std::stod(optarg);
+        break;
+      case 'S':
+        arguments.stats_file = optarg;
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'w':
+        arguments.window = std::stoul(optarg);
+        break;
+      case 'R':
+        arguments.runs = std::stoul(optarg);
+        break;
+      case 'D':
+        arguments.no_pool = true;
+        break;
+      case 'J':
+        arguments.lazy_jit = true;
+        break;
       default:
-        std::cerr << "Usage: kernel_fusion [-N vector-size] [-T trials]\n";
+        std::cerr << "Usage: kernel_fusion [-N vector-size] [-T trials] "
+                     "[-W warmup] [-O outlier-threshold] [-S stats-file] "
+                     "[-P] [-w window] [-R runs] [-D] [-J]\n";
         exit(EXIT_FAILURE);
     }
   }
@@ -41,6 +86,23 @@ arguments_t readArguments(int argc, char* argv[]) {
 void printArguments(const arguments_t& arguments) {
   std::cout << "N: " << arguments.N << "\n";
   std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Runs: " << arguments.runs << "\n";
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  std::cout << "Kernel Bundle: "
+            << (arguments.lazy_jit ? "no, JIT at first launch" : "yes")
+            << "\n";
+  if (0 < arguments.window) {
+    std::cout << "Throughput Window: " << arguments.window << "\n";
+  }
+  std::cout << "Warm-up Trials: " << arguments.warmup << "\n";
+  if (0.0 < arguments.outlier_threshold) {
+    std::cout << "Outlier Threshold: " << arguments.outlier_threshold
+              << " MAD\n";
+  }
+  if (!arguments.stats_file.empty()) {
+    std::cout << "Statistics File: " << arguments.stats_file << "\n";
+  }
   std::cout << "\n";
 }
 
@@ -0,0 +1,73 @@
+#ifndef _GATHER_SCATTER_HPP_
+#define _GATHER_SCATTER_HPP_
+#include <getopt.h>
+
+#include <iostream>
+
+namespace {
+
+struct arguments_t {
+  size_t elements = 8;  // elements along each side of the mesh
+  size_t nodes = 8;     // nodes along each side of an element
+  size_t trials = 100;
+  bool profile = false;
+  bool no_pool = false;
+};
+
+arguments_t readArguments(int argc, char* argv[]) {
+  static struct option long_options[] = {
+      {"elements", required_argument, 0, 'E'},
+      {"nodes", required_argument, 0, 'n'},
+      {"trials", required_argument, 0, 'T'},
+      {"profile", no_argument, 0, 'P'},
+      {"no-pool", no_argument, 0, 'D'},
+      {0, 0, 0, 0}};
+
+  arguments_t arguments;
+  while (1) {
+    int option_index{};
+    int c = getopt_long(argc, argv, "E:n:T:PD", long_options, &option_index);
+    if (0 > c) break;
+
+    switch (c) {
+      case 'E':
+        arguments.elements = std::stoul(optarg);
+        break;
+      case 'n':
+        arguments.nodes = std::stoul(optarg);
+        break;
+      case 'T':
+        arguments.trials = std::stoul(optarg);
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'D':
+        arguments.no_pool = true;
+        break;
+      default:
+        std::cerr << "Usage: gather_scatter [-E or --elements nelements] [-n "
+                     "or --nodes nnodes] [-T or --trials ntrials] [-P or "
+                     "--profile] [-D or --no-pool]\n";
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (1 > arguments.elements || 2 > arguments.nodes) {
+    std::cerr << "Need at least 1 element and 2 nodes per side\n";
+    exit(EXIT_FAILURE);
+  }
+  return arguments;
+}
+
+void printArguments(const arguments_t& arguments) {
+  std::cout << "Mesh: " << arguments.elements << "x" << arguments.elements
+            << " elements of " << arguments.nodes << "x" << arguments.nodes
+            << " nodes\n";
+  std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  std::cout << "\n";
+}
+
+}  // namespace
+#endif
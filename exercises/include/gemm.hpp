@@ -0,0 +1,103 @@
+#ifndef _GEMM_HPP_
+#define _GEMM_HPP_
+#include <getopt.h>
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct arguments_t {
+  // Not a multiple of any block or tile size in the sweep, so the padded edge
+  // blocks are exercised
+  size_t M = 1023;
+  size_t N = 1023;
+  size_t K = 1023;
+  size_t trials = 100;
+  size_t warmup = 0;
+  double outlier_threshold = 0.0;
+  std::string stats_file;
+  bool profile = false;
+  bool no_pool = false;
+};
+
+arguments_t readArguments(int argc, char* argv[]) {
+  static struct option long_options[] = {
+      {"rows", required_argument, 0, 'M'},
+      {"columns", required_argument, 0, 'N'},
+      {"depth", required_argument, 0, 'K'},
+      {"trials", required_argument, 0, 'T'},
+      {"warmup", required_argument, 0, 'W'},
+      {"outlier-threshold", required_argument, 0, 'O'},
+      {"stats-file", required_argument, 0, 'S'},
+      {"profile", no_argument, 0, 'P'},
+      {"no-pool", no_argument, 0, 'D'},
+      {0, 0, 0, 0}};
+
+  arguments_t arguments;
+  while (1) {
+    int option_index{};
+    int c = getopt_long(argc, argv, "M:N:K:T:W:O:S:PD", long_options,
+                        &option_index);
+    if (0 > c) break;
+
+    switch (c) {
+      case 'M':
+        arguments.M = std::stoul(optarg);
+        break;
+      case 'N':
+        arguments.N = std::stoul(optarg);
+        break;
+      case 'K':
+        arguments.K = std::stoul(optarg);
+        break;
+      case 'T':
+        arguments.trials = std::stoul(optarg);
+        break;
+      case 'W':
+        arguments.warmup = std::stoul(optarg);
+        break;
+      case 'O':
+        arguments.outlier_threshold = std::stod(optarg);
+        break;
+      case 'S':
+        arguments.stats_file = optarg;
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'D':
+        arguments.no_pool = true;
+        break;
+      default:
+        std::cerr << "Usage: gemm [-M or --rows nrows] [-N or --columns "
+                     "ncolumns] [-K or --depth ndepth] [-T or --trials "
+                     "ntrials] [-W or --warmup nwarmup] [-O or "
+                     "--outlier-threshold value] [-S or --stats-file file] "
+                     "[-P or --profile] [-D or --no-pool]\n";
+        exit(EXIT_FAILURE);
+    }
+  }
+  return arguments;
+}
+
+void printArguments(const arguments_t& arguments) {
+  std::cout << "M: " << arguments.M << "\n";
+  std::cout << "N: " << arguments.N << "\n";
+  std::cout << "K: " << arguments.K << "\n";
+  std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  std::cout << "Warm-up Trials: " << arguments.warmup << "\n";
+  if (0.0 < arguments.outlier_threshold) {
+    std::cout << "Outlier Threshold: " << arguments.outlier_threshold
+              << " MAD\n";
+  }
+  if (!arguments.stats_file.empty()) {
+    std::cout << "Statistics File: " << arguments.stats_file << "\n";
+  }
+  std::cout << "\n";
+}
+
+}  // namespace
+#endif
@@ -3,24 +3,58 @@
 #include <getopt.h>
 
 #include <iostream>
+#include <string>
 
 namespace {
 
 struct arguments_t {
-  size_t M = 1024;
-  size_t N = 1024;
+  // Not a multiple of the work-group size, so the padded last work-group and
+  // the partial last tile of x are verified
+  size_t M = 1000;
+  size_t N = 1000;
   size_t trials = 5000;
+  size_t warmup = 0;
+  double outlier_threshold = 0.0;
+  std::string stats_file;
+  size_t batch_size = 1;
+  bool run_naive = true;
+  bool run_tiled = true;
+  bool run_sub_group = true;
+  bool trans = false;
+  bool profile = false;
+  size_t window = 0;  // trials in flight in throughput mode, 0 to disable
+  bool no_pool = false;
+  size_t chunk_columns = 0;  // columns of A per staged chunk, 0 to skip
+  double memory_budget = 0.0;  // MiB of device memory when streaming A
+  std::string input;   // matrix file to read A, and optionally x and y, from
+  std::string output;  // matrix file to write A, x and y to
 };
 
 arguments_t readArguments(int argc, char* argv[]) {
-  static struct option long_options[] = {{"rows", required_argument, 0, 'M'},
-                                         {"columns", required_argument, 0, 'N'},
-                                         {"trials", required_argument, 0, 'T'}};
+  static struct option long_options[] = {
+      {"rows", required_argument, 0, 'M'},
+      {"columns", required_argument, 0, 'N'},
+      {"trials", required_argument, 0, 'T'},
+      {"batch-size", required_argument, 0, 'B'},
+      {"kernel", required_argument, 0, 'k'},
+      {"trans", no_argument, 0, 't'},
+      {"warmup", required_argument, 0, 'W'},
+      {"outlier-threshold", required_argument, 0, 'O'},
+      {"stats-file", required_argument, 0, 'S'},
+      {"profile", no_argument, 0, 'P'},
+      {"window", required_argument, 0, 'w'},
+      {"no-pool", no_argument, 0, 'D'},
+      {"chunk-columns", required_argument, 0, 'C'},
+      {"memory-budget", required_argument, 0, 'b'},
+      {"input", required_argument, 0, 'i'},
+      {"output", required_argument, 0, 'o'},
+      {0, 0, 0, 0}};
 
   arguments_t arguments;
   while (1) {
     int option_index{};
-    int c = getopt_long(argc, argv, "M:N:T:", long_options, &option_index);
+    int c = getopt_long(argc, argv, "M:N:T:B:k:tW:O:S:Pw:DC:b:i:o:",
+                        long_options, &option_index);
     if (0 > c) break;
 
     switch (c) {
@@ -32,9 +66,69 @@ arguments_t readArguments(int argc, char* argv[]) {
         break;
       case 'T':
         arguments.trials = std::stoul(optarg);
+        break;
+      case 'B':
+        arguments.batch_size = std::stoul(optarg);
+        if (1 > arguments.batch_size) {
+          std::cerr << "Batch size must be at least 1\n";
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'k': {
+        std::string kernel{optarg};
+        if ("naive" != kernel && "tiled" != kernel && "sub_group" != kernel &&
+            "all" != kernel) {
+          std::cerr << "Unknown kernel: " << kernel << "\n";
+          exit(EXIT_FAILURE);
+        }
+        arguments.run_naive = ("naive" == kernel || "all" == kernel);
+        arguments.run_tiled = ("tiled" == kernel || "all" == kernel);
+        arguments.run_sub_group = ("sub_group" == kernel || "all" == kernel);
+        break;
+      }
+      case 't':
+        arguments.trans = true;
+        break;
+      case 'W':
+        arguments.warmup = std::stoul(optarg);
+        break;
+      case 'O':
+        arguments.outlier_threshold = std::stod(optarg);
+        break;
+      case 'S':
+        arguments.stats_file = optarg;
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'w':
+        arguments.window = std::stoul(optarg);
+        break;
+      case 'D':
+        arguments.no_pool = true;
+        break;
+      case 'C':
+        arguments.chunk_columns = std::stoul(optarg);
+        break;
+      case 'b':
+        arguments.memory_budget = std::stod(optarg);
+        break;
+      case 'i':
+        arguments.input = optarg;
+        break;
+      case 'o':
+        arguments.output = optarg;
+        break;
       default:
         std::cerr << "Usage: gemv_part1 [-M or --rows nrows] [-N or --columns "
-                     "ncolumns] [-T or --trials ntrials] \n";
+                     "ncolumns] [-T or --trials ntrials] [-B or --batch-size "
+                     "nbatch] [-k or --kernel naive|tiled|sub_group|all] "
+                     "[-t or --trans] [-W or --warmup nwarmup] [-O or "
+                     "--outlier-threshold threshold] [-S or --stats-file "
+                     "file.csv|file.json] [-P or --profile] [-w or --window "
+                     "nwindow] [-D or --no-pool] [-C or --chunk-columns "
+                     "ncolumns] [-b or --memory-budget MiB] [-i or --input "
+                     "file] [-o or --output file] \n";
         exit(EXIT_FAILURE);
     }
   }
@@ -45,6 +139,39 @@ void printArguments(const arguments_t& arguments) {
   std::cout << "M: " << arguments.M << "\n";
   std::cout << "N: " << arguments.N << "\n";
   std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Batch Size: " << arguments.batch_size << "\n";
+  std::cout << "Transpose: " << (arguments.trans ? "yes" : "no") << "\n";
+  std::cout << "Kernels:";
+  if (arguments.run_naive) std::cout << " naive";
+  if (arguments.run_tiled) std::cout << " tiled";
+  if (arguments.run_sub_group) std::cout << " sub_group";
+  std::cout << "\n";
+  if (0 < arguments.chunk_columns) {
+    std::cout << "Chunk Columns: " << arguments.chunk_columns << "\n";
+  }
+  if (0.0 < arguments.memory_budget) {
+    std::cout << "Device Memory Budget: " << arguments.memory_budget
+              << " MiB\n";
+  }
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  if (0 < arguments.window) {
+    std::cout << "Throughput Window: " << arguments.window << "\n";
+  }
+  std::cout << "Warm-up Trials: " << arguments.warmup << "\n";
+  if (0.0 < arguments.outlier_threshold) {
+    std::cout << "Outlier Threshold: " << arguments.outlier_threshold
+              << " MAD\n";
+  }
+  if (!arguments.input.empty()) {
+    std::cout << "Input File: " << arguments.input << "\n";
+  }
+  if (!arguments.output.empty()) {
+    std::cout << "Output File: " << arguments.output << "\n";
+  }
+  if (!arguments.stats_file.empty()) {
+    std::cout << "Statistics File: " << arguments.stats_file << "\n";
+  }
   std::cout << "\n";
 }
 
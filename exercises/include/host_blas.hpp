@@ -0,0 +1,218 @@
+#ifndef _HOST_BLAS_HPP_
+#define _HOST_BLAS_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Multithreaded host implementations of the BLAS functions used by the
+// exercises, for verifying device results. All matrices are column-major.
+// The examples are standalone and fill their inputs with constants, so they
+// check each result against its closed-form value instead.
+namespace host_blas {
+
+enum class transpose { nontrans, trans };
+
+// Rows/columns handled together by the blocked loops below. A block of
+// 256 floats (1 KB) stays in L1 while the columns of A stream through.
+constexpr int64_t block_size{256};
+
+// Work smaller than this is not worth starting threads for.
+constexpr int64_t grain_size{1 << 14};
+
+// Split [0, n) into one contiguous chunk per hardware thread and call
+// f(begin, end) for each chunk. The calling thread processes the last chunk.
+template <typename F>
+void parallelFor(int64_t n, int64_t work_per_index, F f) {
+  const int64_t max_threads =
+      std::max<int64_t>(1, std::thread::hardware_concurrency());
+  const int64_t number_of_threads = std::max<int64_t>(
+      1, std::min(max_threads, (n * work_per_index) / grain_size));
+  const int64_t number_of_threads_used = std::min(number_of_threads, n);
+
+  if (number_of_threads_used <= 1) {
+    if (0 < n) f(int64_t(0), n);
+    return;
+  }
+
+  const int64_t chunk_size =
+      (n + number_of_threads_used - 1) / number_of_threads_used;
+  std::vector<std::thread> threads;
+  threads.reserve(number_of_threads_used - 1);
+  for (int64_t begin = 0; begin < n - chunk_size; begin += chunk_size) {
+    threads.emplace_back(f, begin, std::min(begin + chunk_size, n));
+  }
+  const int64_t last_begin = chunk_size * int64_t(threads.size());
+  f(last_begin, n);
+  for (auto& thread : threads) thread.join();
+}
+
+// Computes y += alpha * x
+template <typename T>
+void axpy(int64_t n, T alpha, const T* x, T* y) {
+  parallelFor(n, 1, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      y[i] += alpha * x[i];
+    }
+  });
+}
+
+// Computes the dot product of x and y
+template <typename T>
+T dot(int64_t n, const T* x, const T* y) {
+  // Independent partial sums let the compiler vectorize without reassociating
+  constexpr int lanes{8};
+  const int64_t max_threads =
+      std::max<int64_t>(1, std::thread::hardware_concurrency());
+  std::vector<T> partial_sums(max_threads * lanes, T(0));
+  const int64_t chunk_size = (n + max_threads - 1) / max_threads;
+
+  parallelFor(max_threads, chunk_size, [&](int64_t begin, int64_t end) {
+    for (int64_t t = begin; t < end; ++t) {
+      T sums[lanes]{};
+      const int64_t i_begin = std::min(n, chunk_size * t);
+      const int64_t i_end = std::min(n, i_begin + chunk_size);
+      int64_t i = i_begin;
+      for (; i + lanes <= i_end; i += lanes) {
+        for (int l = 0; l < lanes; ++l) sums[l] += x[i + l] * y[i + l];
+      }
+      for (; i < i_end; ++i) sums[0] += x[i] * y[i];
+      std::copy(sums, sums + lanes, partial_sums.begin() + lanes * t);
+    }
+  });
+
+  T result{};
+  for (const auto& sum : partial_sums) result += sum;
+  return result;
+}
+
+// Given a group of vectors of the same length n, compute
+// for (b=0; b < batch_size; ++b) {
+//   Y += alpha * X
+// }
+// where X is a vector located at offset stride_x * b in x
+// and Y is a vector located at offset stride_y * b in y
+template <typename T>
+void axpy_batch(int64_t n, T alpha, const T* x, int64_t stride_x, T* y,
+                int64_t stride_y, int64_t batch_size) {
+  parallelFor(batch_size, n, [=](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      const T* batch_x = x + stride_x * b;
+      T* batch_y = y + stride_y * b;
+      for (int64_t i = 0; i < n; ++i) {
+        batch_y[i] += alpha * batch_x[i];
+      }
+    }
+  });
+}
+
+namespace detail {
+
+// Single-threaded gemv on rows [i_begin, i_end) of y = alpha * op(A) x +
+// beta * y, where op(A) is m_op x n_op.
+template <typename T>
+void gemvRows(transpose trans, int64_t m, int64_t n, T alpha, const T* a,
+              const T* x, T beta, T* y, int64_t i_begin, int64_t i_end) {
+  if (transpose::nontrans == trans) {
+    // Keep a block of y in cache while sweeping across the columns of A
+    for (int64_t i_block = i_begin; i_block < i_end; i_block += block_size) {
+      const int64_t i_block_end = std::min(i_block + block_size, i_end);
+      T y_block[block_size]{};
+      for (int64_t j = 0; j < n; ++j) {
+        const T x_j = x[j];
+        const T* a_j = a + m * j;
+        for (int64_t i = i_block; i < i_block_end; ++i) {
+          y_block[i - i_block] += a_j[i] * x_j;
+        }
+      }
+      for (int64_t i = i_block; i < i_block_end; ++i) {
+        y[i] = alpha * y_block[i - i_block] + beta * y[i];
+      }
+    }
+  } else {
+    // Each entry of y is the dot product of a contiguous column of A with x
+    constexpr int lanes{8};
+    for (int64_t j = i_begin; j < i_end; ++j) {
+      const T* a_j = a + m * j;
+      T sums[lanes]{};
+      int64_t i = 0;
+      for (; i + lanes <= m; i += lanes) {
+        for (int l = 0; l < lanes; ++l) sums[l] += a_j[i + l] * x[i + l];
+      }
+      for (; i < m; ++i) sums[0] += a_j[i] * x[i];
+      T y_j{};
+      for (int l = 0; l < lanes; ++l) y_j += sums[l];
+      y[j] = alpha * y_j + beta * y[j];
+    }
+  }
+}
+
+}  // namespace detail
+
+// Computes y = alpha * op(A)(x) + beta * y, where A is an m x n matrix
+template <typename T>
+void gemv(transpose trans, int64_t m, int64_t n, T alpha, const T* a,
+          const T* x, T beta, T* y) {
+  const int64_t y_size = (transpose::nontrans == trans) ? m : n;
+  const int64_t work_per_entry = (transpose::nontrans == trans) ? n : m;
+  parallelFor(y_size, work_per_entry, [=](int64_t begin, int64_t end) {
+    detail::gemvRows(trans, m, n, alpha, a, x, beta, y, begin, end);
+  });
+}
+
+// Given a group of matrices and vectors of the same size, compute
+// for (b=0; b < batch_size; ++b) {
+//   Y = alpha * op(A)(X) + beta * Y
+// }
+// where A, X and Y are located at offsets stride_a * b, stride_x * b and
+// stride_y * b in a, x and y.
+template <typename T>
+void gemv_batch(transpose trans, int64_t m, int64_t n, T alpha, const T* a,
+                int64_t stride_a, const T* x, int64_t stride_x, T beta, T* y,
+                int64_t stride_y, int64_t batch_size) {
+  const int64_t y_size = (transpose::nontrans == trans) ? m : n;
+  parallelFor(batch_size, m * n, [=](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      detail::gemvRows(trans, m, n, alpha, a + stride_a * b, x + stride_x * b,
+                       beta, y + stride_y * b, 0, y_size);
+    }
+  });
+}
+
+// Computes C = alpha * A * B + beta * C, where A is m x k, B is k x n and C is
+// m x n, with leading dimensions lda, ldb and ldc.
+template <typename T>
+void gemm(int64_t m, int64_t n, int64_t k, T alpha, const T* a, int64_t lda,
+          const T* b, int64_t ldb, T beta, T* c, int64_t ldc) {
+  // Threads split the columns of C. Each thread works on a block of rows of
+  // C at a time, reusing a k-block of A while sweeping its columns.
+  parallelFor(n, m * k, [=](int64_t j_begin, int64_t j_end) {
+    for (int64_t j = j_begin; j < j_end; ++j) {
+      T* c_j = c + ldc * j;
+      for (int64_t i = 0; i < m; ++i) c_j[i] *= beta;
+    }
+
+    for (int64_t i_block = 0; i_block < m; i_block += block_size) {
+      const int64_t i_block_end = std::min(i_block + block_size, m);
+      for (int64_t k_block = 0; k_block < k; k_block += block_size) {
+        const int64_t k_block_end = std::min(k_block + block_size, k);
+        for (int64_t j = j_begin; j < j_end; ++j) {
+          T* c_j = c + ldc * j;
+          const T* b_j = b + ldb * j;
+          for (int64_t l = k_block; l < k_block_end; ++l) {
+            const T alpha_b_lj = alpha * b_j[l];
+            const T* a_l = a + lda * l;
+            for (int64_t i = i_block; i < i_block_end; ++i) {
+              c_j[i] += a_l[i] * alpha_b_lj;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+}  // namespace host_blas
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef _MATRIX_IO_HPP_
+#define _MATRIX_IO_HPP_
+
+#include <CL/sycl.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A simple binary format for matrices and vectors. A file holds one or more
+// arrays, each a 64 byte header followed by its entries:
+//
+//   offset  size  field
+//        0     8  magic "SYCLMAT\0"
+//        8     4  version
+//       12     4  element type (dtype_t)
+//       16     4  layout (layout_t)
+//       20     4  reserved, zero
+//       24     8  rows
+//       32     8  columns
+//       40     8  leading dimension
+//       48    16  reserved, zero
+//
+// A column-major array stores columns * ld entries, a row-major one rows *
+// ld. Vectors are stored as n x 1 matrices. Headers and entries are in the
+// byte order of the machine that wrote them, and every array starts at a
+// multiple of 64 bytes so its entries can be used in place once mapped.
+namespace matrix_io {
+
+enum class dtype_t : uint32_t { float32 = 1, float64 = 2, float16 = 3 };
+enum class layout_t : uint32_t { column_major = 0, row_major = 1 };
+
+constexpr char magic[8] = {'S', 'Y', 'C', 'L', 'M', 'A', 'T', '\0'};
+constexpr uint32_t version{1};
+constexpr size_t alignment{64};
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  dtype_t dtype;
+  layout_t layout;
+  uint32_t reserved0;
+  uint64_t rows;
+  uint64_t columns;
+  uint64_t ld;
+  uint64_t reserved1[2];
+
+  bool isColumnMajor() const { return layout_t::column_major == layout; }
+
+  // Entries in each column of a column-major array, or in each row of a
+  // row-major one, which the leading dimension must be at least
+  uint64_t minLd() const { return isColumnMajor() ? rows : columns; }
+
+  // Entries stored, including the padding from the leading dimension.
+  // Throws if that does not fit in a size_t.
+  size_t size() const {
+    const uint64_t strides = isColumnMajor() ? columns : rows;
+    if (0 != strides && ld > std::numeric_limits<size_t>::max() / strides) {
+      throw std::overflow_error("Array size overflows");
+    }
+    return strides * ld;
+  }
+};
+static_assert(64 == sizeof(header_t), "header_t must be 64 bytes");
+
+template <typename T>
+struct dtype_of;
+template <>
+struct dtype_of<float> {
+  static constexpr dtype_t value = dtype_t::float32;
+};
+template <>
+struct dtype_of<double> {
+  static constexpr dtype_t value = dtype_t::float64;
+};
+template <>
+struct dtype_of<sycl::half> {
+  static constexpr dtype_t value = dtype_t::float16;
+};
+
+inline size_t elementSize(dtype_t dtype) {
+  switch (dtype) {
+    case dtype_t::float32:
+      return 4;
+    case dtype_t::float64:
+      return 8;
+    case dtype_t::float16:
+      return 2;
+  }
+  throw std::runtime_error("Unknown element type");
+}
+
+// Read-only view of contiguous entries, e.g. of a mapped file or a
+// std::vector, with enough of the std::vector interface to stand in for one.
+template <typename T>
+class array_view_t {
+ public:
+  array_view_t() = default;
+  array_view_t(const T* data, size_t size) : data_{data}, size_{size} {}
+  array_view_t(const std::vector<T>& x) : data_{x.data()}, size_{x.size()} {}
+
+  const T* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return 0 == size_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+  const T& operator[](size_t i) const { return data_[i]; }
+
+ private:
+  const T* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// An array in a file: its header and a view of its entries
+template <typename T>
+struct array_t {
+  header_t header;
+  array_view_t<T> entries;
+};
+
+// Describes an array of rows x columns entries at data, to be written
+template <typename T>
+array_t<T> makeArray(uint64_t rows, uint64_t columns, uint64_t ld,
+                     const T* data,
+                     layout_t layout = layout_t::column_major) {
+  header_t header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.dtype = dtype_of<T>::value;
+  header.layout = layout;
+  header.rows = rows;
+  header.columns = columns;
+  header.ld = ld;
+  if (header.ld < header.minLd()) {
+    throw std::invalid_argument("Leading dimension is too small");
+  }
+  return {header, {data, header.size()}};
+}
+
+// Writes arrays to filename, one after the other
+template <typename T>
+void write(const std::string& filename, const std::vector<array_t<T>>& arrays) {
+  std::ofstream file{filename, std::ios::binary};
+  if (!file) throw std::runtime_error("Cannot open " + filename);
+
+  const char padding[alignment]{};
+  for (const auto& array : arrays) {
+    const size_t bytes = sizeof(T) * array.entries.size();
+    file.write(reinterpret_cast<const char*>(&array.header),
+               sizeof(header_t));
+    file.write(reinterpret_cast<const char*>(array.entries.data()), bytes);
+    file.write(padding, (alignment - bytes % alignment) % alignment);
+  }
+  if (!file) throw std::runtime_error("Error writing " + filename);
+}
+
+// Maps a file into memory read-only. The entries of its arrays are used in
+// place: pages are read from disk as they are first touched, e.g. by the
+// copy to the device, rather than copied into a buffer up front.
+class mapped_file_t {
+ public:
+  explicit mapped_file_t(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (0 > fd) throw std::runtime_error("Cannot open " + filename);
+    struct stat file_stat {};
+    if (0 > fstat(fd, &file_stat)) {
+      close(fd);
+      throw std::runtime_error("Cannot stat " + filename);
+    }
+    size_ = file_stat.st_size;
+    if (0 < size_) {
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED == data) {
+        close(fd);
+        throw std::runtime_error("Cannot map " + filename);
+      }
+      data_ = static_cast<const char*>(data);
+      // The entries are read once, front to back
+      madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    // The destructor does not run if indexing throws
+    try {
+      indexArrays(filename);
+    } catch (...) {
+      if (nullptr != data_) munmap(const_cast<char*>(data_), size_);
+      throw;
+    }
+  }
+
+  mapped_file_t(const mapped_file_t&) = delete;
+  mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+  ~mapped_file_t() {
+    if (nullptr != data_) munmap(const_cast<char*>(data_), size_);
+  }
+
+  size_t numberOfArrays() const { return headers_.size(); }
+  const header_t& header(size_t index) const { return headers_.at(index); }
+
+  // The index-th array, whose entries must be of type T
+  template <typename T>
+  array_t<T> array(size_t index) const {
+    const header_t& header = headers_.at(index);
+    if (dtype_of<T>::value != header.dtype) {
+      throw std::runtime_error("Array " + std::to_string(index) +
+                               " has a different element type");
+    }
+    const T* entries = reinterpret_cast<const T*>(data_ + offsets_[index]);
+    return {header, {entries, header.size()}};
+  }
+
+ private:
+  // Reads and checks the header of each array, and records where its
+  // entries start
+  void indexArrays(const std::string& filename) {
+    for (size_t offset = 0; offset < size_;) {
+      if (size_ - offset < sizeof(header_t)) {
+        throw std::runtime_error(filename + " has a truncated header");
+      }
+      header_t header;
+      std::memcpy(&header, data_ + offset, sizeof(header_t));
+      if (0 != std::memcmp(header.magic, magic, sizeof(magic)) ||
+          version != header.version) {
+        throw std::runtime_error(filename + " is not a matrix file");
+      }
+      if (layout_t::column_major != header.layout &&
+          layout_t::row_major != header.layout) {
+        throw std::runtime_error(filename + " has an unknown layout");
+      }
+      if (header.ld < header.minLd()) {
+        throw std::runtime_error(filename +
+                                 " has a leading dimension too small");
+      }
+      const size_t element_size = elementSize(header.dtype);
+      const size_t size = header.size();
+      if (size > std::numeric_limits<size_t>::max() / element_size) {
+        throw std::runtime_error(filename + " has an array too large");
+      }
+      const size_t bytes = element_size * size;
+      if (size_ - offset - sizeof(header_t) < bytes) {
+        throw std::runtime_error(filename + " has truncated entries");
+      }
+      headers_.push_back(header);
+      offsets_.push_back(offset + sizeof(header_t));
+      offset += sizeof(header_t) +
+                (bytes + alignment - 1) / alignment * alignment;
+    }
+  }
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<header_t> headers_;
+  std::vector<size_t> offsets_;
+};
+
+}  // namespace matrix_io
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef _MEMORY_POOL_HPP_
+#define _MEMORY_POOL_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// A caching allocator for USM device memory. Allocating and freeing device
+// memory can take as long as a small kernel and may synchronize the device,
+// so blocks are kept for reuse instead of being returned to the runtime.
+namespace memory_pool {
+
+// Smallest block handed out. Requests up to large_block_size are rounded up
+// to a power of two; larger ones only to a multiple of large_block_size, so
+// large one-off buffers take at most large_block_size more than requested
+// rather than up to twice as much.
+constexpr size_t min_block_size{256};
+constexpr size_t large_block_size{1 << 20};
+
+struct stats_t {
+  size_t requests;        // calls to allocate
+  size_t hits;            // requests served from the cache
+  size_t bytes_in_use;    // bytes in blocks handed out and not yet freed
+  size_t peak_in_use;
+  size_t bytes_reserved;  // bytes allocated from the runtime, cached or not
+  size_t peak_reserved;
+  double time;            // host time spent in allocate and deallocate (ms)
+
+  double hitRate() const {
+    return (0 < requests) ? double(hits) / double(requests) : 0.0;
+  }
+};
+
+// Device memory from one queue's device and context, binned by size class.
+// Blocks freed with deallocate() are cached in their bin, once all events
+// passed with them have completed, and reused by later requests of the same
+// class. With caching disabled every call goes to sycl::malloc_device and
+// sycl::free, which gives the baseline to compare against.
+class device_pool_t {
+ public:
+  explicit device_pool_t(const sycl::queue& sycl_queue, bool caching = true)
+      : sycl_queue_{sycl_queue}, caching_{caching}, stats_{} {}
+
+  device_pool_t(const device_pool_t&) = delete;
+  device_pool_t& operator=(const device_pool_t&) = delete;
+
+  ~device_pool_t() {
+    release();
+    for (auto& block : in_use_) sycl::free(block.first, sycl_queue_);
+  }
+
+  template <typename T>
+  T* allocate(size_t count) {
+    return static_cast<T*>(allocateBytes(sizeof(T) * count));
+  }
+
+  // Returns ptr to the pool. Its block is not reused until all events have
+  // completed, so it can be freed while kernels using it are still queued.
+  void deallocate(void* ptr, const std::vector<sycl::event>& events = {}) {
+    if (nullptr == ptr) return;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    auto block = in_use_.find(ptr);
+    if (in_use_.end() == block) {
+      throw std::invalid_argument("Pointer was not allocated by this pool");
+    }
+    const size_t size = block->second;
+    in_use_.erase(block);
+    stats_.bytes_in_use -= size;
+
+    if (!caching_) {
+      sycl::event::wait(events);
+      sycl::free(ptr, sycl_queue_);
+      stats_.bytes_reserved -= size;
+    } else if (events.empty()) {
+      free_blocks_[size].push_back(ptr);
+    } else {
+      pending_.push_back({ptr, size, events});
+    }
+    addTime(start_time);
+  }
+
+  // Waits for pending frees and returns all cached blocks to the runtime
+  void release() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto& pending : pending_) {
+      sycl::event::wait(pending.events);
+      free_blocks_[pending.size].push_back(pending.ptr);
+    }
+    pending_.clear();
+    freeCached();
+  }
+
+  stats_t stats() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return stats_;
+  }
+
+ private:
+  struct pending_t {
+    void* ptr;
+    size_t size;
+    std::vector<sycl::event> events;
+  };
+
+  // Size of the blocks used for requests of bytes
+  static size_t sizeClass(size_t bytes) {
+    if (large_block_size < bytes) {
+      return (bytes + large_block_size - 1) / large_block_size *
+             large_block_size;
+    }
+    size_t size = min_block_size;
+    while (size < bytes) size *= 2;
+    return size;
+  }
+
+  static bool isComplete(const sycl::event& event) {
+    return sycl::info::event_command_status::complete ==
+           event.get_info<sycl::info::event::command_execution_status>();
+  }
+
+  void* allocateBytes(size_t bytes) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++stats_.requests;
+
+    const size_t size = sizeClass(std::max<size_t>(1, bytes));
+
+    void* ptr = nullptr;
+    if (caching_) {
+      collectPending();
+      auto& blocks = free_blocks_[size];
+      if (!blocks.empty()) {
+        ptr = blocks.back();
+        blocks.pop_back();
+        ++stats_.hits;
+      }
+    }
+
+    if (nullptr == ptr) {
+      ptr = sycl::malloc_device(size, sycl_queue_);
+      if (nullptr == ptr && caching_) {
+        // Out of memory; return the cached blocks to the runtime and retry
+        for (auto& pending : pending_) sycl::event::wait(pending.events);
+        collectPending();
+        freeCached();
+        ptr = sycl::malloc_device(size, sycl_queue_);
+      }
+      if (nullptr == ptr) throw std::bad_alloc();
+      stats_.bytes_reserved += size;
+      stats_.peak_reserved =
+          std::max(stats_.peak_reserved, stats_.bytes_reserved);
+    }
+
+    in_use_[ptr] = size;
+    stats_.bytes_in_use += size;
+    stats_.peak_in_use = std::max(stats_.peak_in_use, stats_.bytes_in_use);
+    addTime(start_time);
+    return ptr;
+  }
+
+  // Moves blocks whose events have all completed to the free lists
+  void collectPending() {
+    auto is_done = [](const pending_t& pending) {
+      return std::all_of(pending.events.begin(), pending.events.end(),
+                         isComplete);
+    };
+    for (auto& pending : pending_) {
+      if (is_done(pending)) free_blocks_[pending.size].push_back(pending.ptr);
+    }
+    pending_.erase(
+        std::remove_if(pending_.begin(), pending_.end(), is_done),
+        pending_.end());
+  }
+
+  void freeCached() {
+    for (auto& [size, blocks] : free_blocks_) {
+      for (void* ptr : blocks) {
+        sycl::free(ptr, sycl_queue_);
+        stats_.bytes_reserved -= size;
+      }
+      blocks.clear();
+    }
+  }
+
+  void addTime(std::chrono::high_resolution_clock::time_point start_time) {
+    auto finish_time = std::chrono::high_resolution_clock::now();
+    stats_.time +=
+        std::chrono::duration<double, std::milli>(finish_time - start_time)
+            .count();
+  }
+
+  sycl::queue sycl_queue_;
+  const bool caching_;
+  mutable std::mutex mutex_;
+  stats_t stats_;
+  std::map<size_t, std::vector<void*>> free_blocks_;  // by block size
+  std::vector<pending_t> pending_;
+  std::unordered_map<void*, size_t> in_use_;
+};
+
+inline void printStats(const stats_t& s) {
+  std::cout << "Memory Pool\n";
+  std::cout << "requests: " << s.requests << " (" << s.hits << " hits, "
+            << std::fixed << std::setprecision(1) << 100.0 * s.hitRate()
+            << "%)\n";
+  std::cout << "peak in use: " << s.peak_in_use << " bytes\n";
+  std::cout << "peak reserved: " << s.peak_reserved << " bytes\n";
+  std::cout << "time in allocate/deallocate: " << std::scientific
+            << std::setprecision(6) << s.time << " ms\n";
+  std::cout << "\n";
+}
+
+}  // namespace memory_pool
+
+#endif
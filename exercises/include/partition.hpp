@@ -0,0 +1,97 @@
+#ifndef _PARTITION_HPP_
+#define _PARTITION_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Spreading work over several devices, or over sub-devices of one device.
+// A single queue on a multi-socket CPU runs on all sockets, but its memory
+// is not placed near the cores that use it; sub-devices partitioned by NUMA
+// domain keep each partition's data and threads on one socket.
+namespace partition {
+
+enum class mode_t {
+  devices,  // every device of the root device's platform and type
+  equally,  // sub-devices with an equal share of the compute units
+  numa      // one sub-device per NUMA domain
+};
+
+inline mode_t parseMode(const std::string& name) {
+  if ("devices" == name) return mode_t::devices;
+  if ("equally" == name) return mode_t::equally;
+  if ("numa" == name) return mode_t::numa;
+  throw std::invalid_argument("Unknown partitioning " + name);
+}
+
+// The devices to partition work over. With mode_t::equally, count is the
+// number of sub-devices to create; it is otherwise ignored. Throws
+// std::runtime_error if root cannot be partitioned as requested.
+inline std::vector<sycl::device> getDevices(const sycl::device& root,
+                                            mode_t mode, size_t count) {
+  namespace info = sycl::info;
+
+  if (mode_t::devices == mode) {
+    auto devices = root.get_platform().get_devices(
+        root.get_info<info::device::device_type>());
+    if (devices.empty()) devices.push_back(root);
+    return devices;
+  }
+
+  auto properties = root.get_info<info::device::partition_properties>();
+  auto supports = [&](info::partition_property property) {
+    return properties.end() !=
+           std::find(properties.begin(), properties.end(), property);
+  };
+
+  if (mode_t::equally == mode) {
+    if (!supports(info::partition_property::partition_equally)) {
+      throw std::runtime_error("Device cannot be partitioned equally");
+    }
+    const size_t max_sub_devices =
+        root.get_info<info::device::partition_max_sub_devices>();
+    const size_t compute_units =
+        root.get_info<info::device::max_compute_units>();
+    count = std::max<size_t>(1, std::min(count, max_sub_devices));
+
+    // Compute units that do not divide evenly are left idle
+    auto devices =
+        root.create_sub_devices<info::partition_property::partition_equally>(
+            std::max<size_t>(1, compute_units / count));
+    if (devices.size() > count) devices.resize(count);
+    return devices;
+  }
+
+  auto domains = root.get_info<info::device::partition_affinity_domains>();
+  if (!supports(info::partition_property::partition_by_affinity_domain) ||
+      domains.end() == std::find(domains.begin(), domains.end(),
+                                 info::partition_affinity_domain::numa)) {
+    throw std::runtime_error("Device cannot be partitioned by NUMA domain");
+  }
+  return root.create_sub_devices<
+      info::partition_property::partition_by_affinity_domain>(
+      info::partition_affinity_domain::numa);
+}
+
+// Splits n items over partitions in proportion to their weights, e.g. their
+// compute units. Partition p gets items [offsets[p], offsets[p + 1]).
+inline std::vector<size_t> proportionalSplit(
+    size_t n, const std::vector<double>& weights) {
+  const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+  std::vector<size_t> offsets(weights.size() + 1, 0);
+  double sum = 0.0;
+  for (size_t p = 0; p < weights.size(); ++p) {
+    sum += weights[p];
+    offsets[p + 1] = (0.0 < total) ? size_t(double(n) * sum / total + 0.5)
+                                   : n * (p + 1) / weights.size();
+  }
+  offsets.back() = n;
+  return offsets;
+}
+
+}  // namespace partition
+
+#endif
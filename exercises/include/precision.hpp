@@ -0,0 +1,82 @@
+#ifndef _PRECISION_HPP_
+#define _PRECISION_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Helpers for running kernels with reduced-precision storage: converting
+// host data and verifying results with a tolerance based on the precision.
+namespace precision {
+
+template <typename T>
+struct traits;
+
+template <>
+struct traits<double> {
+  static constexpr const char* name = "double";
+  static constexpr double epsilon = 1.1102230246251565e-16;  // 2^-53
+};
+
+template <>
+struct traits<float> {
+  static constexpr const char* name = "float";
+  static constexpr double epsilon = 5.9604644775390625e-08;  // 2^-24
+};
+
+template <>
+struct traits<sycl::half> {
+  static constexpr const char* name = "half";
+  static constexpr double epsilon = 4.8828125e-04;  // 2^-11
+};
+
+// Returns a copy of x, e.g. a std::vector, with each entry converted to To
+template <typename To, typename Array>
+std::vector<To> convert(const Array& x) {
+  std::vector<To> result(x.size());
+  std::transform(x.begin(), x.end(), result.begin(),
+                 [](const auto& x_i) { return static_cast<To>(x_i); });
+  return result;
+}
+
+// Largest difference between actual and expected, relative to the largest
+// magnitude in expected.
+template <typename T, typename U>
+double maxRelativeError(const std::vector<T>& expected,
+                        const std::vector<U>& actual) {
+  double max_error{};
+  double max_expected{};
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const double expected_i = static_cast<double>(expected[i]);
+    const double actual_i = static_cast<double>(actual[i]);
+    max_error = std::max(max_error, std::abs(actual_i - expected_i));
+    max_expected = std::max(max_expected, std::abs(expected_i));
+  }
+  return (0.0 < max_expected) ? max_error / max_expected : max_error;
+}
+
+// Checks that |actual[i] - expected[i]| <= tolerance * scale[i] for all i,
+// where scale[i] bounds the magnitude of the terms summed to give entry i.
+// Returns false and prints the first failing entry otherwise.
+template <typename T, typename U>
+bool verify(const std::vector<T>& expected, const std::vector<U>& actual,
+            const std::vector<T>& scale, double tolerance) {
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const double expected_i = static_cast<double>(expected[i]);
+    const double actual_i = static_cast<double>(actual[i]);
+    if (!(std::abs(actual_i - expected_i) <=
+          tolerance * static_cast<double>(scale[i]))) {
+      std::cout << "Verification failed!\n";
+      std::cout << "expected: " << expected_i << "\n";
+      std::cout << "actual: " << actual_i << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace precision
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _SCAN_HPP_
+#define _SCAN_HPP_
+#include <getopt.h>
+
+#include <iostream>
+
+namespace {
+
+struct arguments_t {
+  size_t N = 100000000;
+  size_t trials = 10;
+  int threshold = 5;  // compaction keeps entries less than the threshold
+  bool profile = false;
+  bool no_pool = false;
+};
+
+arguments_t readArguments(int argc, char* argv[]) {
+  static struct option long_options[] = {
+      {"vector-size", required_argument, 0, 'N'},
+      {"trials", required_argument, 0, 'T'},
+      {"threshold", required_argument, 0, 't'},
+      {"profile", no_argument, 0, 'P'},
+      {"no-pool", no_argument, 0, 'D'},
+      {0, 0, 0, 0}};
+
+  arguments_t arguments;
+  while (1) {
+    int option_index{};
+    int c = getopt_long(argc, argv, "N:T:t:PD", long_options, &option_index);
+    if (0 > c) break;
+
+    switch (c) {
+      case 'N':
+        arguments.N = std::stoul(optarg);
+        break;
+      case 'T':
+        arguments.trials = std::stoul(optarg);
+        break;
+      case 't':
+        arguments.threshold = std::stoi(optarg);
+        break;
+      case 'P':
+        arguments.profile = true;
+        break;
+      case 'D':
+        arguments.no_pool = true;
+        break;
+      default:
+        std::cerr << "Usage: scan [-N or --vector-size N] [-T or --trials "
+                     "ntrials] [-t or --threshold value] [-P or --profile] "
+                     "[-D or --no-pool]\n";
+        exit(EXIT_FAILURE);
+    }
+  }
+  return arguments;
+}
+
+void printArguments(const arguments_t& arguments) {
+  std::cout << "N: " << arguments.N << "\n";
+  std::cout << "Trials: " << arguments.trials << "\n";
+  std::cout << "Compaction Threshold: " << arguments.threshold << "\n";
+  std::cout << "Memory Pool: " << (arguments.no_pool ? "no" : "yes") << "\n";
+  std::cout << "Profiling: " << (arguments.profile ? "yes" : "no") << "\n";
+  std::cout << "\n";
+}
+
+}  // namespace
+#endif
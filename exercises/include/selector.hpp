@@ -0,0 +1,182 @@
+#ifndef _SELECTOR_HPP_
+#define _SELECTOR_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A device selector which scores devices by running short microbenchmarks.
+// sycl::default_selector goes by device type alone, so on a machine with
+// several devices it can pick a slower one. Probing takes a fraction of a
+// second per device, so scores are cached on disk and later runs reuse them.
+namespace selector {
+
+// Aspects a device must have to be selected
+struct requirements_t {
+  bool gpu = false;
+  bool fp64 = false;
+  bool atomic64 = false;
+  bool usm_device = true;
+  bool usm_host = false;
+  bool usm_shared = false;
+};
+
+inline bool meetsRequirements(const sycl::device& sycl_device,
+                              const requirements_t& requirements) {
+  auto meets = [&](bool required, sycl::aspect aspect) {
+    return !required || sycl_device.has(aspect);
+  };
+  return meets(requirements.gpu, sycl::aspect::gpu) &&
+         meets(requirements.fp64, sycl::aspect::fp64) &&
+         meets(requirements.atomic64, sycl::aspect::atomic64) &&
+         meets(requirements.usm_device,
+               sycl::aspect::usm_device_allocations) &&
+         meets(requirements.usm_host, sycl::aspect::usm_host_allocations) &&
+         meets(requirements.usm_shared, sycl::aspect::usm_shared_allocations);
+}
+
+struct score_t {
+  double bandwidth;  // GB/s of a stream triad
+  double gflops;     // GFLOP/s of independent chains of fused multiply-adds
+
+  // Geometric mean of the two, so neither dominates the ranking
+  double value() const { return std::sqrt(bandwidth * gflops); }
+};
+
+// Devices are identified by name and driver version, so scores are probed
+// again after a driver update.
+inline std::string deviceKey(const sycl::device& sycl_device) {
+  return sycl_device.get_info<sycl::info::device::name>() + " (" +
+         sycl_device.get_info<sycl::info::device::driver_version>() + ")";
+}
+
+// Runs launch() a few times after a warm-up and returns the fastest run in
+// seconds.
+template <typename F>
+double bestTime(F launch) {
+  constexpr int number_of_runs{5};
+  launch().wait();
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < number_of_runs; ++run) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    launch().wait();
+    auto finish_time = std::chrono::high_resolution_clock::now();
+    best = std::min(
+        best, std::chrono::duration<double>(finish_time - start_time).count());
+  }
+  return best;
+}
+
+inline score_t probe(const sycl::device& sycl_device) {
+  sycl::queue sycl_queue{sycl_device};
+
+  // Stream triad a = b + s * c over arrays larger than typical caches
+  constexpr size_t n{1 << 22};
+  float* a = sycl::malloc_device<float>(n, sycl_queue);
+  float* b = sycl::malloc_device<float>(n, sycl_queue);
+  float* c = sycl::malloc_device<float>(n, sycl_queue);
+  sycl_queue.fill(b, 1.0f, n);
+  sycl_queue.fill(c, 2.0f, n);
+  sycl_queue.wait();
+
+  const float s = 0.5f;
+  double triad_time = bestTime([&]() {
+    return sycl_queue.parallel_for(sycl::range<1>(n), [=](sycl::id<1> i) {
+      a[i] = b[i] + s * c[i];
+    });
+  });
+
+  // Each work-item runs four independent chains of dependent FMAs, so the
+  // result is bound by arithmetic rather than latency or memory.
+  constexpr size_t work_items{1 << 20};
+  constexpr int iterations{256};
+  double fma_time = bestTime([&]() {
+    return sycl_queue.parallel_for(
+        sycl::range<1>(work_items), [=](sycl::id<1> i) {
+          float x0 = b[i], x1 = x0 + 1.0f, x2 = x0 + 2.0f, x3 = x0 + 3.0f;
+          for (int k = 0; k < iterations; ++k) {
+            x0 = sycl::fma(x0, 0.999f, 0.001f);
+            x1 = sycl::fma(x1, 0.999f, 0.001f);
+            x2 = sycl::fma(x2, 0.999f, 0.001f);
+            x3 = sycl::fma(x3, 0.999f, 0.001f);
+          }
+          a[i] = x0 + x1 + x2 + x3;
+        });
+  });
+
+  sycl::free(a, sycl_queue);
+  sycl::free(b, sycl_queue);
+  sycl::free(c, sycl_queue);
+
+  return {3.0 * sizeof(float) * n / triad_time * 1.0e-9,
+          2.0 * 4.0 * iterations * work_items / fma_time * 1.0e-9};
+}
+
+// Where scores are cached: $SYCL_DEVICE_SCORES if set, otherwise
+// ~/.sycl_device_scores, or the working directory if HOME is not set.
+inline std::string defaultCacheFile() {
+  if (const char* file = std::getenv("SYCL_DEVICE_SCORES")) return file;
+  if (const char* home = std::getenv("HOME")) {
+    return std::string(home) + "/.sycl_device_scores";
+  }
+  return ".sycl_device_scores";
+}
+
+// Selects the device meeting requirements with the highest benchmark score.
+// The cache file holds one device per line: its key, a tab, then its
+// bandwidth and GFLOP/s. Devices missing from it are probed on first use and
+// appended.
+class benchmark_selector_t : public sycl::device_selector {
+ public:
+  explicit benchmark_selector_t(const requirements_t& requirements = {},
+                                std::string cache_file = defaultCacheFile())
+      : requirements_{requirements}, cache_file_{std::move(cache_file)} {
+    std::ifstream file{cache_file_};
+    std::string line;
+    while (std::getline(file, line)) {
+      const size_t tab = line.rfind('\t');
+      if (std::string::npos == tab) continue;
+      std::istringstream values{line.substr(tab + 1)};
+      score_t score{};
+      if (values >> score.bandwidth >> score.gflops) {
+        scores_[line.substr(0, tab)] = score;
+      }
+    }
+  }
+
+  int operator()(const sycl::device& sycl_device) const override {
+    if (!meetsRequirements(sycl_device, requirements_)) return -1;
+    return std::max(1, int(score(sycl_device).value()));
+  }
+
+  // The cached score of sycl_device, probing it if needed
+  score_t score(const sycl::device& sycl_device) const {
+    const std::string key = deviceKey(sycl_device);
+    auto cached = scores_.find(key);
+    if (scores_.end() != cached) return cached->second;
+
+    score_t score = probe(sycl_device);
+    scores_[key] = score;
+    std::ofstream file{cache_file_, std::ios::app};
+    file << key << "\t" << score.bandwidth << " " << score.gflops << "\n";
+    return score;
+  }
+
+ private:
+  requirements_t requirements_;
+  std::string cache_file_;
+  mutable std::map<std::string, score_t> scores_;
+};
+
+}  // namespace selector
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _STAGING_HPP_
+#define _STAGING_HPP_
+
+#include <CL/sycl.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Copies from pageable host memory, e.g. a std::vector, go through a buffer
+// the runtime pins internally, so they are slow and cannot overlap with
+// kernels. Staging splits an upload into chunks which are copied through a
+// ring of pinned sycl::malloc_host buffers: while the device copies one chunk
+// and runs the kernel for it, the host fills the next buffer.
+namespace staging {
+
+class ring_t {
+ public:
+  // number_of_buffers pinned buffers of buffer_size bytes each
+  ring_t(const sycl::queue& sycl_queue, size_t buffer_size,
+         size_t number_of_buffers = 2)
+      : sycl_queue_{sycl_queue},
+        buffer_size_{buffer_size},
+        buffers_(number_of_buffers),
+        copy_events_(number_of_buffers) {
+    for (auto& buffer : buffers_) {
+      buffer = sycl::malloc_host<char>(buffer_size_, sycl_queue_);
+      if (nullptr == buffer) throw std::bad_alloc();
+    }
+  }
+
+  ring_t(const ring_t&) = delete;
+  ring_t& operator=(const ring_t&) = delete;
+
+  ~ring_t() {
+    for (size_t b = 0; b < buffers_.size(); ++b) {
+      copy_events_[b].wait();
+      sycl::free(buffers_[b], sycl_queue_);
+    }
+  }
+
+  // Copies count entries from host memory at src to device memory at dst
+  // through the next buffer of the ring, first waiting for the previous copy
+  // out of that buffer. Returns the event of the copy to the device.
+  template <typename T>
+  sycl::event stage(const T* src, T* dst, size_t count,
+                    const std::vector<sycl::event>& dependencies = {}) {
+    const size_t bytes = sizeof(T) * count;
+    if (bytes > buffer_size_) {
+      throw std::length_error("Chunk is larger than the staging buffers");
+    }
+
+    const size_t b = next_;
+    next_ = (next_ + 1) % buffers_.size();
+
+    copy_events_[b].wait();
+    std::memcpy(buffers_[b], src, bytes);
+    copy_events_[b] = sycl_queue_.memcpy(dst, buffers_[b], bytes, dependencies);
+    return copy_events_[b];
+  }
+
+  size_t bufferSize() const { return buffer_size_; }
+
+ private:
+  sycl::queue sycl_queue_;
+  size_t buffer_size_;
+  std::vector<char*> buffers_;
+  std::vector<sycl::event> copy_events_;
+  size_t next_ = 0;
+};
+
+// Uploads n entries from src to dst through ring, chunk entries at a time,
+// calling process(offset, count, copy_event) as soon as each chunk has been
+// submitted. process launches the work on that chunk, depending on its copy,
+// and returns its event. Returns the events of all chunks.
+template <typename T, typename F>
+std::vector<sycl::event> upload(ring_t& ring, const T* src, T* dst, size_t n,
+                                size_t chunk, F process) {
+  std::vector<sycl::event> events;
+  for (size_t offset = 0; offset < n; offset += chunk) {
+    const size_t count = (n - offset < chunk) ? n - offset : chunk;
+    sycl::event copy_event = ring.stage(src + offset, dst + offset, count);
+    events.push_back(process(offset, count, copy_event));
+  }
+  return events;
+}
+
+}  // namespace staging
+
+#endif
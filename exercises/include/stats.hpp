@@ -1,8 +1,14 @@
 #ifndef _STATS_HPP_
 #define _STATS_HPP_
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace stats
@@ -10,48 +16,421 @@ namespace stats
   template<typename T>
   struct stats_t
   {
+    size_t count;      // samples used to compute the statistics
+    size_t discarded;  // warm-up samples dropped from the front
+    size_t outliers;   // samples rejected as outliers
     T total;
     T mean;
     T min;
     T max;
     T median;
+    T p90;
+    T p99;
+    T p999;
     T variance;
     T stddev;
+    T ci95;  // half-width of the 95% confidence interval of the mean
     std::string units;
   };
 
+  struct options_t
+  {
+    // Number of samples to drop from the front of the dataset, e.g., trials
+    // which include JIT compilation or cold caches.
+    size_t warmup = 0;
+    // Reject samples whose distance from the median is more than this many
+    // (scaled) median absolute deviations. Zero disables outlier rejection.
+    double outlier_threshold = 0.0;
+  };
+
+  // Streaming estimate of a single quantile using the P^2 algorithm of
+  // Jain and Chlamtac (1985); uses constant memory regardless of the number
+  // of samples.
+  class quantile_t
+  {
+   public:
+    explicit quantile_t(double p) : p_(p) {}
+
+    void push(double x)
+    {
+      if (count_ < 5)
+      {
+        q_[count_++] = x;
+        if (5 == count_)
+        {
+          std::sort(q_, q_ + 5);
+          for (int i = 0; i < 5; ++i) n_[i] = i;
+          np_[0] = 0.0;
+          np_[1] = 2.0 * p_;
+          np_[2] = 4.0 * p_;
+          np_[3] = 2.0 + 2.0 * p_;
+          np_[4] = 4.0;
+          dn_[0] = 0.0;
+          dn_[1] = p_ / 2.0;
+          dn_[2] = p_;
+          dn_[3] = (1.0 + p_) / 2.0;
+          dn_[4] = 1.0;
+        }
+        return;
+      }
+
+      // Find the cell containing x, extending the extreme markers if needed
+      int k;
+      if (x < q_[0])
+      {
+        q_[0] = x;
+        k = 0;
+      }
+      else if (x >= q_[4])
+      {
+        q_[4] = x;
+        k = 3;
+      }
+      else
+      {
+        k = 0;
+        while (x >= q_[k + 1]) ++k;
+      }
+
+      for (int i = k + 1; i < 5; ++i) n_[i] += 1.0;
+      for (int i = 0; i < 5; ++i) np_[i] += dn_[i];
+
+      // Move the middle markers towards their desired positions
+      for (int i = 1; i < 4; ++i)
+      {
+        const double d = np_[i] - n_[i];
+        if ((d >= 1.0 && n_[i + 1] - n_[i] > 1.0) ||
+            (d <= -1.0 && n_[i - 1] - n_[i] < -1.0))
+        {
+          const double s = (d < 0.0) ? -1.0 : 1.0;
+          const double q = parabolic(i, s);
+          if (q_[i - 1] < q && q < q_[i + 1])
+          {
+            q_[i] = q;
+          }
+          else
+          {
+            const int j = i + static_cast<int>(s);
+            q_[i] += s * (q_[j] - q_[i]) / (n_[j] - n_[i]);
+          }
+          n_[i] += s;
+        }
+      }
+      ++count_;
+    }
+
+    double value() const
+    {
+      if (0 == count_) return std::numeric_limits<double>::quiet_NaN();
+      if (count_ < 5)
+      {
+        std::vector<double> sorted(q_, q_ + count_);
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[static_cast<size_t>(p_ * (count_ - 1) + 0.5)];
+      }
+      return q_[2];
+    }
+
+   private:
+    double parabolic(int i, double s) const
+    {
+      return q_[i] + s / (n_[i + 1] - n_[i - 1]) *
+                         ((n_[i] - n_[i - 1] + s) * (q_[i + 1] - q_[i]) /
+                              (n_[i + 1] - n_[i]) +
+                          (n_[i + 1] - n_[i] - s) * (q_[i] - q_[i - 1]) /
+                              (n_[i] - n_[i - 1]));
+    }
+
+    double p_;
+    size_t count_ = 0;
+    double q_[5]{};   // marker heights
+    double n_[5]{};   // marker positions
+    double np_[5]{};  // desired marker positions
+    double dn_[5]{};  // increments of the desired positions
+  };
+
+  // Accumulates statistics one sample at a time without storing the samples,
+  // for runs with too many trials to keep. The mean and variance use
+  // Welford's algorithm; percentiles are P^2 estimates. Outlier rejection
+  // needs the full dataset, so it is only available through computeStats.
+  template<typename T>
+  class accumulator_t
+  {
+   public:
+    explicit accumulator_t(size_t warmup = 0) : warmup_(warmup) {}
+
+    void push(T x)
+    {
+      if (discarded_ < warmup_)
+      {
+        ++discarded_;
+        return;
+      }
+      ++count_;
+      const double delta = x - mean_;
+      mean_ += delta / count_;
+      m2_ += delta * (x - mean_);
+      total_ += x;
+      min_ = std::min(min_, static_cast<double>(x));
+      max_ = std::max(max_, static_cast<double>(x));
+      for (auto& q : quantiles_) q.push(x);
+    }
+
+    size_t count() const { return count_; }
+
+    stats_t<T> stats(std::string units) const
+    {
+      stats_t<T> s{};
+      s.units = units;
+      s.count = count_;
+      s.discarded = discarded_;
+      s.outliers = 0;
+      s.total = total_;
+      s.mean = mean_;
+      s.min = min_;
+      s.max = max_;
+      s.median = quantiles_[0].value();
+      s.p90 = quantiles_[1].value();
+      s.p99 = quantiles_[2].value();
+      s.p999 = quantiles_[3].value();
+      s.variance = (count_ > 0) ? m2_ / count_ : 0.0;
+      s.stddev = std::sqrt(s.variance);
+      s.ci95 = confidence95(s.stddev, count_);
+      return s;
+    }
+
+    // Half-width of the 95% confidence interval of the mean, using the
+    // normal approximation.
+    static T confidence95(T stddev, size_t count)
+    {
+      if (count < 2) return T(0);
+      return 1.96 * stddev / std::sqrt(static_cast<T>(count - 1));
+    }
+
+   private:
+    size_t warmup_;
+    size_t discarded_ = 0;
+    size_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double total_ = 0.0;
+    double min_ = std::numeric_limits<double>::infinity();
+    double max_ = -std::numeric_limits<double>::infinity();
+    quantile_t quantiles_[4]{quantile_t(0.5), quantile_t(0.9),
+                             quantile_t(0.99), quantile_t(0.999)};
+  };
+
+  // Percentile of sorted data, interpolating linearly between samples
+  template<typename T>
+  inline T percentile(const std::vector<T>& sorted, double p)
+  {
+    if (sorted.empty()) return std::numeric_limits<T>::quiet_NaN();
+    const double position = p * (sorted.size() - 1);
+    const size_t below = static_cast<size_t>(position);
+    const size_t above = std::min(below + 1, sorted.size() - 1);
+    const double weight = position - below;
+    return (1.0 - weight) * sorted[below] + weight * sorted[above];
+  }
+
   template<typename T>
-  inline stats_t<T> computeStats(std::vector<T>& dataset,std::string units)
+  inline stats_t<T> computeStats(std::vector<T>& dataset, std::string units,
+                                 const options_t& options = {})
   {
-    stats_t<T> s;
-    s.units = units;
-    std::sort(dataset.begin(), dataset.end());
-    s.total = std::accumulate(dataset.begin(), dataset.end(), T(0));
-    s.mean = s.total / static_cast<T>(dataset.size());
-    s.min = dataset.front();
-    s.median = dataset[dataset.size()/2L];
-    s.max = dataset.back();
+    // Drop warm-up samples before sorting, while the data is still in order
+    const size_t warmup = std::min(options.warmup, dataset.size());
+    std::vector<T> samples(dataset.begin() + warmup, dataset.end());
+    std::sort(samples.begin(), samples.end());
 
-    s.variance = T(0);
-    for (auto &x : dataset)
+    size_t outliers = 0;
+    if (0.0 < options.outlier_threshold && !samples.empty())
     {
-      s.variance += (x * x);
+      // Scaling the MAD by 1.4826 makes it estimate the standard deviation
+      // of normally distributed data.
+      const T median = percentile(samples, 0.5);
+      std::vector<T> deviations(samples.size());
+      std::transform(samples.begin(), samples.end(), deviations.begin(),
+                     [=](T x) { return std::abs(x - median); });
+      std::sort(deviations.begin(), deviations.end());
+      const T mad = 1.4826 * percentile(deviations, 0.5);
+      const T limit = options.outlier_threshold * mad;
+
+      auto is_outlier = [=](T x) { return std::abs(x - median) > limit; };
+      if (T(0) < mad)
+      {
+        const size_t size = samples.size();
+        samples.erase(
+            std::remove_if(samples.begin(), samples.end(), is_outlier),
+            samples.end());
+        outliers = size - samples.size();
+      }
     }
-    s.variance /= static_cast<T>(dataset.size());
-    s.variance -= (s.mean * s.mean);
-    s.stddev = std::sqrt(s.variance);
+
+    accumulator_t<T> accumulator;
+    for (auto& x : samples) accumulator.push(x);
+
+    stats_t<T> s = accumulator.stats(units);
+    s.discarded = warmup;
+    s.outliers = outliers;
+    s.median = percentile(samples, 0.5);
+    s.p90 = percentile(samples, 0.9);
+    s.p99 = percentile(samples, 0.99);
+    s.p999 = percentile(samples, 0.999);
     return s;
   }
 
   template<typename T,size_t N=6>
   void printStats(const stats_t<T>& stats) {
     std::cout.precision(N);
-    std::cout << "mean: " << std::scientific << stats.mean << stats.units << "\n";
-    std::cout << "std: " << std::scientific << stats.mean << stats.units << "\n";
+    std::cout << "mean: " << std::scientific << stats.mean << stats.units
+              << " +/- " << stats.ci95 << stats.units << " (95% CI)\n";
+    std::cout << "std: " << std::scientific << stats.stddev << stats.units << "\n";
     std::cout << "min: " << std::scientific << stats.min << stats.units << "\n";
+    std::cout << "p50: " << std::scientific << stats.median << stats.units << "\n";
+    std::cout << "p90: " << std::scientific << stats.p90 << stats.units << "\n";
+    std::cout << "p99: " << std::scientific << stats.p99 << stats.units << "\n";
+    std::cout << "p99.9: " << std::scientific << stats.p999 << stats.units << "\n";
     std::cout << "max: " << std::scientific <<  stats.max << stats.units << "\n";
+    std::cout << "samples: " << stats.count << " (" << stats.discarded
+              << " warm-up, " << stats.outliers << " outliers discarded)\n";
     std::cout << "\n";
   }
 
+  // A named set of statistics plus any derived metrics, e.g., bandwidth,
+  // which should be written out alongside them.
+  template<typename T>
+  struct record_t
+  {
+    std::string name;
+    stats_t<T> stats;
+    std::vector<std::pair<std::string, double>> metrics;
+  };
+
+  template<typename T>
+  void writeCSV(std::ostream& os, const std::vector<record_t<T>>& records)
+  {
+    // Derived metrics become extra columns, one per name used by any
+    // record in order of first use; records without one leave it empty
+    std::vector<std::string> metric_names;
+    for (auto& record : records)
+    {
+      for (auto& metric : record.metrics)
+      {
+        if (std::find(metric_names.begin(), metric_names.end(),
+                      metric.first) == metric_names.end())
+        {
+          metric_names.push_back(metric.first);
+        }
+      }
+    }
+
+    os << "name,units,count,discarded,outliers,mean,stddev,ci95,min,p50,"
+          "p90,p99,p999,max";
+    for (auto& metric_name : metric_names) os << "," << metric_name;
+    os << "\n";
+
+    os.precision(std::numeric_limits<T>::max_digits10);
+    for (auto& record : records)
+    {
+      const auto& s = record.stats;
+      os << record.name << "," << s.units << "," << s.count << ","
+         << s.discarded << "," << s.outliers << "," << s.mean << ","
+         << s.stddev << "," << s.ci95 << "," << s.min << "," << s.median
+         << "," << s.p90 << "," << s.p99 << "," << s.p999 << "," << s.max;
+      for (auto& metric_name : metric_names)
+      {
+        os << ",";
+        for (auto& metric : record.metrics)
+        {
+          if (metric.first == metric_name)
+          {
+            os << metric.second;
+            break;
+          }
+        }
+      }
+      os << "\n";
+    }
+  }
+
+  template<typename T>
+  void writeJSON(std::ostream& os, const std::vector<record_t<T>>& records)
+  {
+    // JSON has no inf or nan, which are left when no samples remain, e.g.,
+    // after warm-up and outlier rejection; write those as null
+    auto field = [&](const std::string& key, double value) {
+      os << ", \"" << key << "\": ";
+      if (std::isfinite(value))
+      {
+        os << value;
+      }
+      else
+      {
+        os << "null";
+      }
+    };
+
+    os.precision(std::numeric_limits<T>::max_digits10);
+    os << "[\n";
+    for (size_t r = 0; r < records.size(); ++r)
+    {
+      const auto& s = records[r].stats;
+      os << "  {\"name\": \"" << records[r].name << "\", \"units\": \""
+         << s.units << "\", \"count\": " << s.count
+         << ", \"discarded\": " << s.discarded
+         << ", \"outliers\": " << s.outliers;
+      field("mean", s.mean);
+      field("stddev", s.stddev);
+      field("ci95", s.ci95);
+      field("min", s.min);
+      field("p50", s.median);
+      field("p90", s.p90);
+      field("p99", s.p99);
+      field("p999", s.p999);
+      field("max", s.max);
+      for (auto& metric : records[r].metrics)
+      {
+        field(metric.first, metric.second);
+      }
+      os << "}" << ((r + 1 < records.size()) ? "," : "") << "\n";
+    }
+    os << "]\n";
+  }
+
+  // Write records to filename as CSV or JSON, depending on its extension.
+  // Returns false if the file cannot be written.
+  template<typename T>
+  bool writeRecords(const std::string& filename,
+                    const std::vector<record_t<T>>& records)
+  {
+    auto has_extension = [&](const std::string& extension) {
+      return filename.size() >= extension.size() &&
+             0 == filename.compare(filename.size() - extension.size(),
+                                   extension.size(), extension);
+    };
+
+    const bool is_json = has_extension(".json");
+    if (!is_json && !has_extension(".csv"))
+    {
+      std::cerr << "Statistics file must end in .csv or .json\n";
+      return false;
+    }
+
+    std::ofstream file(filename);
+    if (!file)
+    {
+      std::cerr << "Unable to open " << filename << "\n";
+      return false;
+    }
+    if (is_json)
+    {
+      writeJSON(file, records);
+    }
+    else
+    {
+      writeCSV(file, records);
+    }
+    return true;
+  }
+
 }
 #endif
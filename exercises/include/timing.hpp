@@ -0,0 +1,239 @@
+#ifndef _TIMING_HPP_
+#define _TIMING_HPP_
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "stats.hpp"
+
+// Helpers for timing kernels on the host and, when the queue was created
+// with sycl::property::queue::enable_profiling, on the device.
+namespace timing {
+
+struct timings_t {
+  std::vector<double> host;    // wall-clock time of each trial (ms)
+  std::vector<double> device;  // device time of each trial (ms), if profiling
+};
+
+inline bool isProfiling(const sycl::queue& sycl_queue) {
+  return sycl_queue.has_property<sycl::property::queue::enable_profiling>();
+}
+
+// Time on the device, in ms, from the start of the first command to the end
+// of the last command associated with events. For a chain of kernels this
+// includes any idle time between them.
+inline double deviceTime(const std::vector<sycl::event>& events) {
+  namespace event_profiling = sycl::info::event_profiling;
+  uint64_t start = UINT64_MAX;
+  uint64_t end = 0;
+  for (const auto& event : events) {
+    start = std::min(
+        start,
+        event.get_profiling_info<event_profiling::command_start>());
+    end = std::max(
+        end, event.get_profiling_info<event_profiling::command_end>());
+  }
+  return (end > start) ? 1.0e-6 * double(end - start) : 0.0;
+}
+
+inline std::vector<sycl::event> toEvents(const sycl::event& event) {
+  return {event};
+}
+
+inline std::vector<sycl::event> toEvents(std::vector<sycl::event> events) {
+  return events;
+}
+
+// Call launch() number_of_trials times, waiting for each trial to finish.
+// launch() returns the event, or events, of the work submitted by a trial.
+template <typename F>
+timings_t timeTrials(sycl::queue& sycl_queue, size_t number_of_trials,
+                     F launch) {
+  const bool is_profiling = isProfiling(sycl_queue);
+
+  timings_t timings;
+  timings.host.resize(number_of_trials);
+  if (is_profiling) timings.device.resize(number_of_trials);
+
+  for (size_t trial = 0; trial < number_of_trials; ++trial) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto events = toEvents(launch());
+    sycl::event::wait(events);
+    auto finish_time = std::chrono::high_resolution_clock::now();
+    timings.host[trial] =
+        std::chrono::duration<double, std::milli>(finish_time - start_time)
+            .count();
+    if (is_profiling) timings.device[trial] = deviceTime(events);
+  }
+  return timings;
+}
+
+struct throughput_t {
+  size_t iterations;
+  size_t window;  // maximum number of trials in flight
+  double time;    // wall-clock time of all trials (ms)
+
+  double timePerIteration() const { return time / double(iterations); }
+  double iterationsPerSecond() const {
+    return 1.0e3 * double(iterations) / time;
+  }
+};
+
+// Submit number_of_trials trials back-to-back without waiting for each one.
+// launch(dependencies) submits a trial that depends on the events of the
+// previous trial and returns its event, or events. At most window trials are
+// in flight: before submitting another the host waits for the oldest one.
+// The clock stops once everything submitted to sycl_queue has completed.
+template <typename F>
+throughput_t timeThroughput(sycl::queue& sycl_queue, size_t number_of_trials,
+                            size_t window, F launch) {
+  window = std::max<size_t>(1, window);
+  std::deque<std::vector<sycl::event>> in_flight;
+  std::vector<sycl::event> previous;
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (size_t trial = 0; trial < number_of_trials; ++trial) {
+    if (in_flight.size() >= window) {
+      sycl::event::wait(in_flight.front());
+      in_flight.pop_front();
+    }
+    previous = toEvents(launch(previous));
+    in_flight.push_back(previous);
+  }
+  sycl_queue.wait();
+  auto finish_time = std::chrono::high_resolution_clock::now();
+
+  return {number_of_trials, window,
+          std::chrono::duration<double, std::milli>(finish_time - start_time)
+              .count()};
+}
+
+struct timing_stats_t {
+  bool has_device;
+  stats::stats_t<double> host;
+  stats::stats_t<double> device;
+  // Host time minus device time, i.e., submission, scheduling and wake-up
+  stats::stats_t<double> overhead;
+
+  // Best available measure of the time spent executing the kernels
+  const stats::stats_t<double>& kernel() const {
+    return has_device ? device : host;
+  }
+};
+
+inline timing_stats_t computeStats(timings_t& timings,
+                                   const stats::options_t& options) {
+  timing_stats_t s{};
+  s.has_device = !timings.device.empty();
+  s.host = stats::computeStats(timings.host, "ms", options);
+  if (s.has_device) {
+    std::vector<double> overhead(timings.host.size());
+    for (size_t i = 0; i < overhead.size(); ++i) {
+      overhead[i] = timings.host[i] - timings.device[i];
+    }
+    s.device = stats::computeStats(timings.device, "ms", options);
+    s.overhead = stats::computeStats(overhead, "ms", options);
+  }
+  return s;
+}
+
+// Prints host statistics, or host, device and overhead side by side
+inline void printStats(const timing_stats_t& s) {
+  if (!s.has_device) {
+    stats::printStats(s.host);
+    return;
+  }
+
+  const int width = 15;
+  auto row = [&](const char* label, double host, double device,
+                 double overhead) {
+    std::cout << std::left << std::setw(7) << label << std::right
+              << std::scientific << std::setprecision(6) << std::setw(width)
+              << host << std::setw(width) << device << std::setw(width)
+              << overhead << "\n";
+  };
+
+  std::cout << std::setw(7) << "(ms)" << std::setw(width) << "host"
+            << std::setw(width) << "device" << std::setw(width) << "overhead"
+            << "\n";
+  row("mean:", s.host.mean, s.device.mean, s.overhead.mean);
+  row("std:", s.host.stddev, s.device.stddev, s.overhead.stddev);
+  row("min:", s.host.min, s.device.min, s.overhead.min);
+  row("p50:", s.host.median, s.device.median, s.overhead.median);
+  row("p90:", s.host.p90, s.device.p90, s.overhead.p90);
+  row("p99:", s.host.p99, s.device.p99, s.overhead.p99);
+  row("max:", s.host.max, s.device.max, s.overhead.max);
+  std::cout << "samples: " << s.host.count << " (" << s.host.discarded
+            << " warm-up, " << s.host.outliers << " outliers discarded)\n";
+  std::cout << "\n";
+}
+
+// The effective bandwidth of an algorithm which, at best, reads and writes
+// bytes in time_ms
+inline void printBandwidth(double bytes, double time_ms) {
+  std::cout << "Effective Bandwidth: " << std::fixed
+            << (bytes / time_ms) * 1.0e-6 << " GB/s\n\n";
+}
+
+// Compares throughput against the mean latency in s. Bandwidths are printed
+// if the number of bytes moved by one trial is given.
+inline void printThroughput(const throughput_t& throughput,
+                            const timing_stats_t& s, double bytes = 0.0) {
+  const double latency = s.host.mean;
+  std::cout << std::left << std::setw(12) << "" << std::right
+            << std::setw(15) << "latency" << std::setw(15) << "throughput"
+            << "\n";
+  std::cout << std::left << std::setw(12) << "ms/iter:" << std::right
+            << std::scientific << std::setprecision(6) << std::setw(15)
+            << latency << std::setw(15) << throughput.timePerIteration()
+            << "\n";
+  std::cout << std::left << std::setw(12) << "iter/s:" << std::right
+            << std::setw(15) << 1.0e3 / latency << std::setw(15)
+            << throughput.iterationsPerSecond() << "\n";
+  if (0.0 < bytes) {
+    std::cout << std::left << std::setw(12) << "GB/s:" << std::right
+              << std::setw(15) << 1.0e-6 * bytes / latency << std::setw(15)
+              << 1.0e-6 * bytes / throughput.timePerIteration() << "\n";
+  }
+  std::cout << "(" << throughput.iterations << " trials, at most "
+            << throughput.window << " in flight)\n\n";
+}
+
+// Metrics describing throughput, to attach to a record
+inline std::vector<std::pair<std::string, double>> throughputMetrics(
+    const throughput_t& throughput, double bytes = 0.0) {
+  std::vector<std::pair<std::string, double>> metrics{
+      {"iterations_per_second", throughput.iterationsPerSecond()}};
+  if (0.0 < bytes) {
+    metrics.push_back(
+        {"throughput_gbps", 1.0e-6 * bytes / throughput.timePerIteration()});
+  }
+  return metrics;
+}
+
+// Append records for s to records; with profiling, one record each is
+// written for the host time, device time and overhead.
+inline void appendRecords(
+    std::vector<stats::record_t<double>>& records, const std::string& name,
+    const timing_stats_t& s,
+    const std::vector<std::pair<std::string, double>>& metrics = {}) {
+  if (!s.has_device) {
+    records.push_back({name, s.host, metrics});
+    return;
+  }
+  records.push_back({name + "_host", s.host, metrics});
+  records.push_back({name + "_device", s.device, metrics});
+  records.push_back({name + "_overhead", s.overhead, metrics});
+}
+
+}  // namespace timing
+
+#endif